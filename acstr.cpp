@@ -13,11 +13,28 @@
  * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
  */
 
+#include <algorithm>
 #include "acstr.hpp"
 #include "solver.hpp"
 
 Constraint::Constraint(CPSolver::Ptr cp)
    : _scheduled(false),
+     _idempotent(false),
      _prio(CHIGH),
+     _weight(1),
+     _id(cp->nextConstraintId()),
      _active(cp->getStateManager(),true)
 {}
+
+void Constraint::inScope(WeightedDegree* d)
+{
+   if (d->_last == this)
+      return;
+   d->_last = this;
+   if (std::find(_scope.begin(),_scope.end(),d) != _scope.end())
+      return;     // on the variable again, after another constraint
+   _scope.push_back(d);
+   d->_total += _weight;
+   if (!_active)
+      d->_inactive = d->_inactive + _weight;
+}
@@ -16,10 +16,91 @@
 #ifndef __ACSTR_H
 #define __ACSTR_H
 
+#include <atomic>
+#include <limits>
+#include <vector>
 #include "handle.hpp"
 #include "trailable.hpp"
+#include "literal.hpp"
 
 class CPSolver;
+
+/**
+ * @brief One change of the domain of a variable, as handed to an advisor (see Constraint::advise).
+ *
+ * Values leave the domain either with its bounds (the values of \f$[oldMin,newMin)\f$ and
+ * \f$(newMax,oldMax]\f$) or, one at a time, from its inside (`hole()`). The ranges are only
+ * given by their bounds, they may contain values that had already left the domain.
+ * When the advised variable is a view, the delta is expressed in the values of the view.
+ */
+class IntDelta {
+   int  _oldMin,_oldMax,_newMin,_newMax,_hole;
+   int  _a,_b;   // the advised variable is a * x + b
+   bool _inside;
+   int at(int v) const noexcept { return _a * v + _b;}
+public:
+   /**
+    * A change of bounds (and possibly of the inside of the domain) of `x`
+    */
+   IntDelta(int oldMin,int oldMax,int newMin,int newMax) noexcept
+      : _oldMin(oldMin),_oldMax(oldMax),_newMin(newMin),_newMax(newMax),_hole(0),_a(1),_b(0),_inside(false) {}
+   /**
+    * The removal of `v` from the inside of the domain of `x` (bounds unchanged)
+    */
+   IntDelta(int min,int max,int v) noexcept
+      : _oldMin(min),_oldMax(max),_newMin(min),_newMax(max),_hole(v),_a(1),_b(0),_inside(true) {}
+   /**
+    * The same delta, seen through the view \f$a * x + b\f$ (composed with the view of this delta)
+    */
+   IntDelta map(int a,int b) const noexcept {
+      IntDelta d(*this);
+      d._b = a * _b + b;
+      d._a = a * _a;
+      return d;
+   }
+   int oldMin() const noexcept { return _a > 0 ? at(_oldMin) : at(_oldMax);}
+   int oldMax() const noexcept { return _a > 0 ? at(_oldMax) : at(_oldMin);}
+   int newMin() const noexcept { return _a > 0 ? at(_newMin) : at(_newMax);}
+   int newMax() const noexcept { return _a > 0 ? at(_newMax) : at(_newMin);}
+   bool minChanged() const noexcept { return oldMin() != newMin();}
+   bool maxChanged() const noexcept { return oldMax() != newMax();}
+   bool isBound() const noexcept    { return _newMin == _newMax;}
+   /**
+    * @return true if and only if a single value left the inside of the domain (see `hole()`)
+    */
+   bool inside() const noexcept     { return _inside;}
+   int hole() const noexcept        { return at(_hole);}
+   /**
+    * @return an upper bound on the number of values that left the domain
+    */
+   int span() const noexcept { return _inside ? 1 : (_newMin - _oldMin) + (_oldMax - _newMax);}
+   /**
+    * Calls `f` on every value that may have left the domain (see `span()`)
+    */
+   template <class F> void removed(F f) const {
+      if (_inside)
+         f(at(_hole));
+      else {
+         for(int v = _oldMin;v < _newMin;v++) f(at(v));
+         for(int v = _newMax + 1;v <= _oldMax;v++) f(at(v));
+      }
+   }
+};
+
+class Constraint;
+
+/**
+ * @brief The weighted degree of a variable (see var<int>::weightedDegree), kept up to date by the constraints
+ * in its scope: their weights are added to `_total` and, while they are inactive, to `_inactive` as well.
+ */
+struct WeightedDegree {
+   unsigned long        _total;     // the weights of the constraints on the variable (never restored)
+   trail<unsigned long> _inactive;  // the weights of the inactive ones
+   Constraint*          _last;      // the constraint that entered the scope last
+   WeightedDegree(Trailer::Ptr sm) : _total(0),_inactive(sm,0),_last(nullptr) {}
+   unsigned long value() const noexcept { return _total - _inactive;}
+};
+
 /**
  * @brief This is an abstract constraint.
  * 
@@ -30,17 +111,31 @@ class CPSolver;
 class Constraint {
 private:
    bool     _scheduled;
+   bool     _idempotent;
    unsigned char _prio;
+   unsigned    _weight;
+   unsigned long _id;
    trail<bool> _active;
+   std::vector<WeightedDegree*> _scope;   // of the variables the constraint is on
 public:
    /**
-    * @brief Low priority level for the propagator (2 levels only)
+    * @brief Priority tiers, by cost class of the propagator. Cheaper tiers are propagated first.
+    * A constraint that does not declare its tier is CHIGH, as with the former two levels.
+    */
+   static const unsigned char UNARY     = 0;   //!< a single variable
+   static const unsigned char BINARY    = 1;   //!< a few variables, constant time
+   static const unsigned char LINEAR    = 2;   //!< linear in the arity (sums, clauses, elements, ...)
+   static const unsigned char QUADRATIC = 3;   //!< super-linear reasoning (timetables, automata, ...)
+   static const unsigned char GLOBAL    = 4;   //!< heavy global reasoning (matchings, tables, MDDs)
+   static const unsigned char NBPRIO    = 5;
+   /**
+    * @brief Low priority level for the propagator (kept for compatibility: the heaviest tier)
     */
-   static const unsigned char CLOW  = 0;
+   static const unsigned char CLOW  = GLOBAL;
    /**
-    * @brief High priority level for the propagator (2 levels only)
+    * @brief High priority level for the propagator (kept for compatibility: the binary tier)
     */
-   static const unsigned char CHIGH = 1;
+   static const unsigned char CHIGH = BINARY;
    /**
     * @brief Smart pointer type to an abstract Constraint 
     */
@@ -59,21 +154,63 @@ public:
     * @brief propagate API called when an event (AC3) occurs on a variable in the scope of this constraint
     */
    virtual void propagate() {}
+   /**
+    * @brief advise API called on every change of a variable the constraint advises on
+    * (see var<int>::adviseOnBoundChange and var<int>::adviseOnDomainChange), while the domain
+    * is being updated. It may record the delta (to let `propagate` work on the changes only) or fail,
+    * but must not update any domain.
+    * A constraint that keeps deltas until its next `propagate` must schedule itself whenever it keeps one.
+    * Being scheduled does not mean the kept deltas are current: a failure outside of the fixpoint
+    * leaves the constraint scheduled. Use trailed state to detect deltas undone by backtracking (see TableCT).
+    * @param idx the index given when the advisor was registered
+    * @param d the change of the domain
+    * @return true if the constraint must be scheduled
+    */
+   virtual bool advise(int idx,const IntDelta& d) { return true;}
+   /**
+    * @brief explain API used while learning (see CPSolver::setLearning). It is called right before
+    * the propagator enforces `l`, while the domains are still the ones it reasoned on.
+    * Literals on a view are obtained with var<int>::literal.
+    * @param l the literal about to be enforced
+    * @param reason receives literals, true in the current domains, that imply `l` with the constraint
+    * @return false if the propagator cannot explain `l` (all the decisions taken so far are then its reason)
+    */
+   virtual bool explain(const Literal& l,std::vector<Literal>& reason) { return false;}
+   /**
+    * @brief Same as `explain` for a failure of the propagator: the literals make the constraint infeasible.
+    */
+   virtual bool explainFailure(std::vector<Literal>& reason) { return false;}
    /**
     * @brief Printing. Convenience printing API
     * @param os the stream the constraint is to be printed to
     */
    virtual void print(std::ostream& os) const {}
    /**
-    * Sets the priority of the constraint to a new value from \f$\{0,1\}\f$
+    * Sets the priority tier of the constraint (from `UNARY` to `GLOBAL`)
     * @param p the new priority
     */
    void setPriority(unsigned char p) { _prio = p;}
    /**
-    * Retrieves the priority currently assigned to this constraint.
-    * @return the assigned priority (either 0 or 1)
+    * Retrieves the priority tier currently assigned to this constraint.
+    * @return the assigned priority (lower tiers run first)
     */
    unsigned char getPriority() const { return _prio;}
+   /**
+    * Declares the propagator idempotent: running it twice in a row never prunes more than running it once.
+    * The solver then ignores the events the propagator causes on its own variables while it runs.
+    * @param i true if the propagator is idempotent (the default is false)
+    */
+   void setIdempotent(bool i) { _idempotent = i;}
+   /**
+    * Retrieves the `idempotent` flag of the constraint.
+    * @return true if and only if the propagator was declared idempotent.
+    */
+   bool isIdempotent() const { return _idempotent;}
+   /**
+    * @return the rank of the constraint among those created by its solver. Unlike the address of
+    * the constraint, which backtracking may hand to a later constraint, it identifies the constraint.
+    */
+   unsigned long getId() const noexcept { return _id;}
    /**
     * Tags the constraint as currently scheduled (it is in a propagation queue)
     * @param s is true if the constraint is scheduled. False otherwise.
@@ -86,23 +223,87 @@ public:
    bool isScheduled() const  { return _scheduled;}
    /**
     * Change the `active` flag of the constraint. Inactive constraints are skipped during propagation.
+    * A propagator deactivates itself once it is entailed: the variables then drop it from their
+    * listeners the next time they notify them, so that later events no longer reach it. Both the flag
+    * and the listeners are restored on backtrack.
     * @param a the active flag to be set.
     */
-   void setActive(bool a)    { _active = a;}
+   void setActive(bool a) {
+      if (a != _active)
+         for(WeightedDegree* d : _scope)
+            d->_inactive = a ? d->_inactive - _weight : d->_inactive + _weight;
+      _active = a;
+   }
    /**
     * Retrieves the `active` flag of the constraint.
     * @return true if and only if the constraint is currently active.
     */
    bool isActive() const     { return _active;}
+   /**
+    * Retrieves the weight of the constraint (see var<int>::weightedDegree).
+    * @return 1 plus the number of times its propagator failed
+    */
+   unsigned weight() const   { return _weight;}
+   /**
+    * Called by the solver when the propagator fails.
+    */
+   virtual void incWeight() {
+      ++_weight;
+      for(WeightedDegree* d : _scope)
+         d->_total += 1;
+   }
+   /**
+    * Adds a variable to the scope of the constraint, unless it is there already (see var<int>::weightedDegree).
+    * @param d the weighted degree of the variable
+    */
+   void inScope(WeightedDegree* d);
 };
 
 class ConstraintDesc {
 public:
    typedef strict_ptr<ConstraintDesc> Ptr;
    ConstraintDesc() {}
+   virtual ~ConstraintDesc() {}
    virtual Constraint* create() = 0;
    virtual ConstraintDesc* clone() = 0;
    virtual void print(std::ostream& os) const {}
+   /**
+    * Describes the constraint as a Literal when it is an atomic decision on a single variable.
+    * @param l the literal to fill in
+    * @return true if and only if the constraint is a literal (and `l` was set).
+    */
+   virtual bool literal(Literal& l) const { return false;}
+};
+
+/**
+ * @brief Incumbent value shared by the objective functions of several solvers (typically
+ * one per thread) that work on the same model.
+ *
+ * The incumbent is kept as a key where lower is better (\f$v\f$ for a minimization and
+ * \f$-v\f$ for a maximization) and only ever improves.
+ * @see Objective::share
+ */
+class Incumbent {
+   std::atomic<long long> _key;
+public:
+   typedef handle_ptr<Incumbent> Ptr;
+   Incumbent() : _key(std::numeric_limits<long long>::max()) {}
+   /**
+    * Returns the best key published so far (`LLONG_MAX` if none)
+    */
+   long long key() const noexcept { return _key.load(std::memory_order_acquire);}
+   /**
+    * Publishes a new key.
+    * @param k the key to publish
+    * @return true if and only if `k` is strictly better than the previous key.
+    */
+   bool improve(long long k) noexcept {
+      long long cur = _key.load(std::memory_order_relaxed);
+      while (k < cur)
+         if (_key.compare_exchange_weak(cur,k,std::memory_order_acq_rel,std::memory_order_relaxed))
+            return true;
+      return false;
+   }
 };
 
 /**
@@ -131,6 +332,12 @@ public:
    virtual int primal() const = 0;
    virtual double optimalityGap() const = 0;
    virtual bool isMin() const = 0;
+   /**
+    * Attaches an incumbent shared with the objectives of other solvers. New primal bounds
+    * are published to it and pruning honors the best bound published by anyone.
+    * @param inc the shared incumbent
+    */
+   virtual void share(Incumbent::Ptr inc) {}
 };;
 
 #endif
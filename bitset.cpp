@@ -64,6 +64,7 @@ SparseBitSet::SparseBitSet(Trailer::Ptr eng, Storage::Ptr store, int sz)
    }
    if (_sz & 0x1f)
       _words[_nbWords - 1] = (_words[_nbWords - 1] & ~(0xffffffff >> (_sz % 32)));
+   eng->track(_index.data(),_nbWords * sizeof(int));   // only _limit is trailed: snapshots need the permutation too
 }
 
 void SparseBitSet::clearBit(int b)
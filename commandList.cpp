@@ -16,6 +16,57 @@
 #include "commandList.hpp"
 
 static __thread struct CommandListPool* pool = nullptr;
+static __thread struct CommandNode* freeNodes = nullptr;
+static __thread CommandMemory memory = { 0,0,0,0 };
+
+#define NODESLAB 256
+
+CommandNode* CommandNode::allocate() {
+   if (!freeNodes) {
+      CommandNode* slab = (CommandNode*)malloc(sizeof(CommandNode) * NODESLAB);
+      for (int i = 0; i < NODESLAB; i++) {
+         slab[i]._next = freeNodes;
+         freeNodes = slab + i;
+      }
+   }
+   CommandNode* n = freeNodes;
+   freeNodes = n->_next;
+   n->_refs = 1;
+   if (++memory.nodes > memory.maxNodes)
+      memory.maxNodes = memory.nodes;
+   return n;
+}
+void CommandNode::release(CommandNode* n) {
+   while (n && --n->_refs == 0) {
+      CommandNode* next = n->_next;
+      if (n->_constraint)
+         n->_constraint.free();
+      n->_next = freeNodes;
+      freeNodes = n;
+      memory.nodes--;
+      n = next;
+   }
+}
+PathNode* PathNode::make(CommandList* list,PathNode* parent) {
+   PathNode* n = new PathNode { list,parent,1,parent ? parent->_depth + 1 : 1 };
+   if (parent)
+      parent->_refs++;
+   if (++memory.paths > memory.maxPaths)
+      memory.maxPaths = memory.paths;
+   return n;
+}
+void PathNode::release(PathNode* n) {
+   while (n && --n->_refs == 0) {
+      PathNode* parent = n->_parent;
+      n->_list->letgo();
+      delete n;
+      memory.paths--;
+      n = parent;
+   }
+}
+CommandMemory& CommandMemory::current() {
+   return memory;
+}
 
 CommandList* CommandList::grab() {
    _refCount++;
@@ -24,8 +75,11 @@ CommandList* CommandList::grab() {
 void CommandList::letgo() {
    assert(_refCount > 0);
    if (--_refCount == 0) {
+      CommandNode::release(_head);
       _head = nullptr;
       _nodeID = -1;
+      delete _snapshot;
+      _snapshot = nullptr;
       struct CommandListPool* pool = CommandList::instancePool();
       unsigned int next = (pool->_high + 1) % pool->_maxSize;
       if (next != pool->_low) {
@@ -37,8 +91,19 @@ void CommandList::letgo() {
 }
 void CommandList::insert(ConstraintDesc::Ptr c) {
    assert(!_frozen);
-   struct CommandNode* newNode = (struct CommandNode*)malloc(sizeof(struct CommandNode));
+   struct CommandNode* newNode = CommandNode::allocate();
    newNode->_constraint = c;
+   newNode->_x = nullptr;
+   newNode->_next = _head;
+   _head = newNode;
+}
+void CommandList::insert(var<int>* x,Literal::Rel rel,int val) {
+   assert(!_frozen);
+   struct CommandNode* newNode = CommandNode::allocate();
+   newNode->_constraint = nullptr;
+   newNode->_x = x;
+   newNode->_rel = rel;
+   newNode->_val = val;
    newNode->_next = _head;
    _head = newNode;
 }
@@ -58,6 +123,14 @@ void CommandList::freeze() {
 bool CommandList::frozen() {
    return _frozen;
 }
+void CommandList::setSnapshot(Snapshot* s) {
+   assert(_frozen);
+   delete _snapshot;
+   _snapshot = s;
+}
+Snapshot* CommandList::snapshot() {
+   return _snapshot;
+}
 struct CommandNode* CommandList::head() {
    return _head;
 }
@@ -105,7 +178,9 @@ void CommandList::print() {
    struct CommandNode* node = _head;
    while (node != nullptr) {
       std::cout << "    ";
-      printCstrDesc(node->_constraint);
+      if (node->isDecision())
+         std::cout << Literal(node->_x->getId(),node->_rel,node->_val) << "\n";
+      else printCstrDesc(node->_constraint);
       node = node->_next;
    }
    std::cout << "  }\n";
@@ -142,6 +217,14 @@ void CommandStack::addCommand(ConstraintDesc::Ptr constraint) {
    }
    _table[_size-1]->insert(constraint);
 }
+void CommandStack::addDecision(var<int>* x,Literal::Rel rel,int val) {
+   CommandList* commandList = _table[_size-1];
+   if (commandList->frozen()) {
+      _table[_size-1] = new CommandList(*commandList);
+      commandList->letgo();
+   }
+   _table[_size-1]->insert(x,rel,val);
+}
 //void CommandStack::setMemoryTail(unsigned int memoryTail) {
 //   if (_size >= 1) {
 //      if (_table[_size-1]->frozen()) {
@@ -162,10 +245,10 @@ CommandList* CommandStack::peekAt(unsigned int index) {
 int CommandStack::size() {
    return _size;
 }
-unsigned int CommandStack::sharedPrefixSize(CommandStack* other) {
+unsigned int CommandStack::sharedPrefixSize(const std::vector<CommandList*>& other) {
    unsigned int i;
-   unsigned int minSize = std::min(_size, other->size());
-   for (i = 0; i < minSize && *(_table[i]) == *(other->peekAt(i)); i++);
+   unsigned int minSize = std::min((unsigned int)_size, (unsigned int)other.size());
+   for (i = 0; i < minSize && *(_table[i]) == *(other[i]); i++);
    return i;
 }
 void CommandStack::print() {
@@ -179,7 +262,10 @@ void CommandStack::print() {
 //   return _memoryTrail;
 //}
 unsigned int Checkpoint::size() {
-   return _path->size();
+   return _tail ? _tail->_depth : 0;
+}
+PathNode* Checkpoint::tail() {
+   return _tail;
 }
 void Checkpoint::setNodeID(unsigned int nodeID) {
    _nodeID = nodeID;
@@ -190,8 +276,20 @@ unsigned int Checkpoint::nodeID() {
 void Checkpoint::setLevel(unsigned int level) {
    _level = level;
 }
-CommandStack* Checkpoint::commands() {
-   return _path;
+void Checkpoint::path(std::vector<CommandList*>& into) {
+   into.resize(size());
+   for (PathNode* p = _tail; p; p = p->_parent)
+      into[p->_depth - 1] = p->_list;
+}
+bool Checkpoint::decisions(Checkpoint& from,std::vector<Literal>& into) {
+   PathNode* p = _tail;
+   for (; p && p != from._tail; p = p->_parent)
+      for (struct CommandNode* node = p->_list->head(); node != nullptr; node = node->_next) {
+         if (!node->isDecision())
+            return false;
+         into.emplace_back(node->_x->getId(),node->_rel,node->_val);
+      }
+   return p == from._tail;
 }
 unsigned int Checkpoint::level() {
    return _level;
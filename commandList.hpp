@@ -17,14 +17,53 @@
 #define commandList_hpp
 
 #include "constraint.hpp"
+#include "snapshot.hpp"
 
+/**
+ * A command is either a constraint description or, for a decision \f$x = v\f$ or \f$x \neq v\f$,
+ * a compact record applied directly to the domain of the variable on replay.
+ * Nodes are shared by the lists copied from one another (copy-on-write) and reference counted.
+ */
 struct CommandNode {
-  ConstraintDesc::Ptr _constraint;
+  ConstraintDesc::Ptr _constraint;   // nullptr for a decision
+  var<int>*           _x;
+  int                 _val;
+  Literal::Rel        _rel;
+  unsigned int        _refs;
   struct CommandNode* _next;
+  bool isDecision() const noexcept { return !_constraint;}
+  static CommandNode* allocate();
+  static void release(CommandNode* n);
 };
 
 class CommandList;
 
+/**
+ * A level of the prefix tree formed by the paths of the checkpoints. A checkpoint only holds the
+ * deepest node of its path: checkpoints taken below a common node share that node and its
+ * ancestors instead of each holding a copy of the whole path. Nodes are reference counted.
+ */
+struct PathNode {
+  CommandList*     _list;
+  struct PathNode* _parent;
+  unsigned int     _refs;
+  unsigned int     _depth;   // number of lists on the path, this one included
+  static PathNode* make(CommandList* list,PathNode* parent);
+  static void release(PathNode* n);
+};
+
+/**
+ * @brief Command nodes and path nodes alive in the calling thread (with their peaks).
+ */
+struct CommandMemory {
+  long nodes;
+  long maxNodes;
+  long paths;
+  long maxPaths;
+  std::size_t bytes() const noexcept { return nodes * sizeof(CommandNode) + paths * sizeof(PathNode);}
+  static CommandMemory& current();
+};
+
 struct CommandListPool {
   unsigned int _low;
   unsigned int _high;
@@ -40,19 +79,25 @@ class CommandList {
 //  unsigned int       _to;
   unsigned int _refCount;
   bool  _frozen;
+  Snapshot* _snapshot;   // the state once the commands of the list (and those before it) are posted
 public:
   CommandList(long nodeID) : //, unsigned int from, unsigned int to) :
-    _head(nullptr), _nodeID(nodeID), /*_from(from), _to(to),*/ _refCount(1), _frozen(false) { }
+    _head(nullptr), _nodeID(nodeID), /*_from(from), _to(to),*/ _refCount(1), _frozen(false), _snapshot(nullptr) { }
   CommandList(const CommandList& c) :
-    _head(c._head), _nodeID(c._nodeID), /*_from(c._from), _to(c._to),*/ _refCount(c._refCount), _frozen(false) { }
+    _head(c._head), _nodeID(c._nodeID), /*_from(c._from), _to(c._to),*/ _refCount(1), _frozen(false), _snapshot(nullptr) {
+    if (_head) _head->_refs++;
+  }
   CommandList* grab();
   void letgo();
   void insert(ConstraintDesc::Ptr c);
+  void insert(var<int>* x,Literal::Rel rel,int val);
 //  void setMemoryTo(unsigned int tail);
 //  unsigned int memoryFrom();
 //  unsigned int memoryTo();
   void freeze();
   bool frozen();
+  void setSnapshot(Snapshot* s);
+  Snapshot* snapshot();
   struct CommandNode* head();
   unsigned int length();
   long nodeID();
@@ -73,41 +118,44 @@ public:
   void pushList(unsigned int nodeID);//, unsigned int memoryHead);
   void pushCommandList(CommandList* list);
   void addCommand(ConstraintDesc::Ptr constraint);
+  void addDecision(var<int>* x,Literal::Rel rel,int val);
   //void setMemoryTail(unsigned int memoryTail);
   CommandList* popList();
   CommandList* peekAt(unsigned int index);
   int size();
-  unsigned int sharedPrefixSize(CommandStack* other);
+  unsigned int sharedPrefixSize(const std::vector<CommandList*>& other);
   void print();
 };
 
 class Checkpoint {
-  CommandStack* _path;
+  PathNode* _tail;   // the deepest level of the path (nullptr for an empty path)
   unsigned int _nodeID;
   //unsigned int _refCount;
   //MemoryTrail* _memoryTrail;
   unsigned int _level;
 public:
-  Checkpoint(CommandStack* commands) : //, MemoryTrail* memoryTrail) :
-    _nodeID(-1)/*, _refCount(1), _memoryTrail(memoryTrail)*/, _level(-1) {
-    _path = new CommandStack(64);
-    unsigned int stackSize = commands->size();
-    for (unsigned int i = 0; i < stackSize; i++) {
-//      assert(i == 0 || commands->peekAt(i)->memoryFrom() >= commands->peekAt(i-1)->memoryTo());
-      CommandList* list = commands->peekAt(i);
-      list->grab();
-      list->freeze();
-      _path->pushCommandList(list);
-    }
-  }
-  ~Checkpoint() { delete _path; }
+  /**
+   * @param tail the deepest level of the path (the checkpoint takes over one reference to it)
+   */
+  Checkpoint(PathNode* tail) : //, MemoryTrail* memoryTrail) :
+    _tail(tail), _nodeID(-1)/*, _refCount(1), _memoryTrail(memoryTrail)*/, _level(-1) { }
+  ~Checkpoint() { PathNode::release(_tail); }
   //MemoryTrail* memoryTrail();
   unsigned int size();
+  PathNode* tail();
   void setNodeID(unsigned int nodeID);
   unsigned int nodeID();
   void setLevel(unsigned int level);
   unsigned int level();
-  CommandStack* commands();
+  /**
+   * Lists the command lists of the path, from the root down.
+   */
+  void path(std::vector<CommandList*>& into);
+  /**
+   * Collects the decisions posted on the path below the checkpoint `from`.
+   * @return false if `from` is not on the path or if some command below it is not a decision
+   */
+  bool decisions(Checkpoint& from,std::vector<Literal>& into);
 //  Checkpoint* grab();
 //  void letgo();
 };
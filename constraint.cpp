@@ -14,6 +14,7 @@
  */
 
 #include "constraint.hpp"
+#include "lcg.hpp"
 #include <string.h>
 #include <limits>
 
@@ -45,6 +46,11 @@ void EQcDesc::print(std::ostream& os) const
 {
    os << _x << " == " << _c;
 }
+bool EQcDesc::literal(Literal& l) const
+{
+   l = Literal(_x->getId(),Literal::EQ,_c);
+   return _x->getId() >= 0;
+}
 
 void NEQc::post()
 {
@@ -63,21 +69,82 @@ void NEQcDesc::print(std::ostream& os) const
 {
    os << _x << " != " << _c;
 }
+bool NEQcDesc::literal(Literal& l) const
+{
+   l = Literal(_x->getId(),Literal::NEQ,_c);
+   return _x->getId() >= 0;
+}
+
+void LEQc::post()
+{
+   _x->removeAbove(_c);
+}
+
+LEQc* LEQcDesc::create()
+{
+   return new (_x->getSolver()) LEQc(_x,_c);
+}
+LEQcDesc* LEQcDesc::clone()
+{
+   return new LEQcDesc(_x,_c);
+}
+void LEQcDesc::print(std::ostream& os) const
+{
+   os << _x << " <= " << _c;
+}
+bool LEQcDesc::literal(Literal& l) const
+{
+   l = Literal(_x->getId(),Literal::LEQ,_c);
+   return _x->getId() >= 0;
+}
+
+void GEQc::post()
+{
+   _x->removeBelow(_c);
+}
+
+GEQc* GEQcDesc::create()
+{
+   return new (_x->getSolver()) GEQc(_x,_c);
+}
+GEQcDesc* GEQcDesc::clone()
+{
+   return new GEQcDesc(_x,_c);
+}
+void GEQcDesc::print(std::ostream& os) const
+{
+   os << _x << " >= " << _c;
+}
+bool GEQcDesc::literal(Literal& l) const
+{
+   l = Literal(_x->getId(),Literal::GEQ,_c);
+   return _x->getId() >= 0;
+}
 
 void EQBinBC::post()
 {
-   if (_x->isBound())
-      _y->assign(_x->min() - _c);
-   else if (_y->isBound())
-      _x->assign(_y->min() + _c);
+   IntVarImpl* cx = concrete(_x),*cy = concrete(_y);
+   if (cx && cy)
+      post(cx,cy);
+   else
+      post(_x.get(),_y.get());
+}
+
+template <class X,class Y> void EQBinBC::post(X* x,Y* y)
+{
+   const int c = _c;
+   if (x->isBound())
+      y->assign(x->min() - c);
+   else if (y->isBound())
+      x->assign(y->min() + c);
    else {
-      _x->updateBounds(_y->min() + _c,_y->max() + _c);
-      _y->updateBounds(_x->min() - _c,_x->max() - _c);
-      _x->whenBoundsChange([this] {
-         _y->updateBounds(_x->min() - _c,_x->max() - _c);
+      x->updateBounds(y->min() + c,y->max() + c);
+      y->updateBounds(x->min() - c,x->max() - c);
+      x->whenBoundsChange([x,y,c] {
+         y->updateBounds(x->min() - c,x->max() - c);
       });
-      _y->whenBoundsChange([this] {
-         _x->updateBounds(_y->min() + _c,_y->max() + _c);
+      y->whenBoundsChange([x,y,c] {
+         x->updateBounds(y->min() + c,y->max() + c);
       });
    }
 }
@@ -208,11 +275,13 @@ void EQBinDC::post()
 
 void EQBinDC::propagate()
 {
-   if (_x->isBound())
+   if (_x->isBound()) {
       _y->assign(_x->min() - _c);
-   else if (_y->isBound())
+      setActive(false);
+   } else if (_y->isBound()) {
       _x->assign(_y->min() + _c);
-   else {
+      setActive(false);
+   } else {
       _x->updateBounds(_y->min() + _c,_y->max() + _c);
       _y->updateBounds(_x->min() - _c,_x->max() - _c);
       int lx = _x->min(), ux = _x->max();
@@ -270,15 +339,33 @@ void LessOrEqual::post()
     
 void LessOrEqual::propagate()
 {
-   _x->removeAbove(_y->max());
-   _y->removeBelow(_x->min());
-   setActive(_x->max() >= _y->min());
+   if (_cx && _cy)
+      propagate(_cx,_cy);
+   else
+      propagate(_x.get(),_y.get());
+}
+
+template <class X,class Y> void LessOrEqual::propagate(X* x,Y* y)
+{
+   x->removeAbove(y->max());
+   y->removeBelow(x->min());
+   if (x->max() <= y->min())
+      setActive(false);
+}
+
+bool LessOrEqual::explain(const Literal& l,std::vector<Literal>& reason)
+{
+   reason.push_back(_x->literal(Literal::GEQ,_x->min()));
+   reason.push_back(_y->literal(Literal::LEQ,_y->max()));
+   return true;
 }
 
 Minimize::Minimize(var<int>::Ptr& x)
    : _obj(x),_primal(0x7FFFFFFF)
 {
    auto todo = std::function<void(void)>([this]() {
+      if (_shared && _shared->key() < _primal)
+         _primal = (int)_shared->key();
       _obj->removeAbove(_primal - 1);
    });
    _obj->getSolver()->onFixpoint(todo);
@@ -293,6 +380,8 @@ void Minimize::tighten()
 {
     //assert(_obj->isBound());
    _primal = _obj->max();
+   if (_shared)
+      _shared->improve(_primal);
    failNow();
 }
 
@@ -301,6 +390,8 @@ void Minimize::foundPrimal(int primal)
    if (primal < _primal) {
 std::cout << "Primal: " << primal << "\n";
       _primal = primal;
+      if (_shared)
+         _shared->improve(_primal);
       _obj->removeAbove(_primal - 1);
    }
 } 
@@ -309,6 +400,8 @@ Maximize::Maximize(var<int>::Ptr& x)
    : _obj(x),_primal(0x80000001)
 {
    auto todo = std::function<void(void)>([this]() {
+      if (_shared && -_shared->key() > _primal)
+         _primal = (int)-_shared->key();
       TRYFAIL
          //std::cout << "1=====> objective primal:" << _primal << "  z = " << _obj << std::endl;
          _obj->removeBelow(_primal + 1);
@@ -329,6 +422,8 @@ void Maximize::tighten()
 {
    assert(_obj->isBound());
    _primal = _obj->min();
+   if (_shared)
+      _shared->improve(-(long long)_primal);
    failNow();
 }
 
@@ -336,6 +431,8 @@ void Maximize::foundPrimal(int primal)
 {
    if (primal > _primal) {
       _primal = primal;
+      if (_shared)
+         _shared->improve(-(long long)_primal);
       _obj->removeBelow(_primal + 1);
    }
 } 
@@ -506,39 +603,34 @@ void IsLessOrEqual::post()
 
 void Sum::post()
 {
-   for(auto& var : _x)
-      var->propagateOnBoundChange(this);
+   int sumMin = 0,sumMax = 0;
+   for(auto i=0u;i < _n;i++) {
+      sumMin += _x[i]->min();
+      sumMax += _x[i]->max();
+      _x[i]->adviseOnBoundChange(this,i);
+   }
+   _sumMin = sumMin;
+   _sumMax = sumMax;
    propagate();
 }
 
+bool Sum::advise(int,const IntDelta& d)
+{
+   if (d.minChanged()) _sumMin += d.newMin() - d.oldMin();
+   if (d.maxChanged()) _sumMax += d.newMax() - d.oldMax();
+   return true;
+}
+
 void Sum::propagate()
 {  
+   if (0 < _sumMin ||  _sumMax < 0)
+      failNow();
    int nU = _nUnBounds;
-   int sumMin = _sumBounds,sumMax = _sumBounds;
    var<int>::Ptr* x = _x.data();
-   for(int i = nU - 1; i >= 0;i--) {
-      const auto idx = _unBounds[i];
-      const int vMin = x[idx]->min();
-      const int vMax = x[idx]->max();
-      sumMin += vMin;
-      sumMax += vMax;
-      if (vMin == vMax) {
-         _sumBounds = _sumBounds + vMin;
-         _unBounds[i] = _unBounds[nU - 1];
-         _unBounds[nU - 1] = idx;
-         nU--;
-      }
-   }
-   //_nUnBounds = nU;
-   if (0 < sumMin ||  sumMax < 0)
-      failNow();
+   IntVarImpl** cx = _cx.data();
    for(int i = nU - 1; i >= 0;i--) {
       auto idx = _unBounds[i];
-      const auto xU = -(sumMin - x[idx]->min()),xL = -(sumMax - x[idx]->max());
-      x[idx]->removeAbove(xU);
-      x[idx]->removeBelow(xL);
-      if (xL == xU) {
-         _sumBounds += xL;
+      if (cx[idx] ? narrow(cx[idx]) : narrow(x[idx].get())) {
          _unBounds[i] = _unBounds[--nU];
          _unBounds[nU] = idx;
       }
@@ -547,6 +639,12 @@ void Sum::propagate()
    if (nU == 0) setActive(false);
 }
 
+bool Sum::explain(const Literal& l,std::vector<Literal>& reason)
+{
+   LCG::allBounds(_x,reason);
+   return true;
+}
+
 void SumBool::post() 
 {
    int nbTrue = 0,nbPos = 0;
@@ -611,20 +709,36 @@ void SumBool::propagateIdx(int k)
 }
 
 
-Clause::Clause(const std::vector<var<bool>::Ptr>& x)
+NoGood::NoGood(const std::vector<var<int>::Ptr>& x,const std::vector<int>& v)
    : Constraint(x[0]->getSolver()),
+     _x(x),
+     _v(v),
      _wL(x[0]->getSolver()->getStateManager(),0),
-     _wR(x[0]->getSolver()->getStateManager(),(int)x.size() - 1)
+     _wR(x[0]->getSolver()->getStateManager(),(int)x.size() - 1),
+     _hL(x[0]->getSolver()->getStateManager(),nullptr),
+     _hR(x[0]->getSolver()->getStateManager(),nullptr)
 {
-   for(auto xi : x) _x.push_back(xi);
+   setPriority(LINEAR);
 }
 
-void Clause::propagate()
+// Subscribes to the decision `w` unless the subscription `h` (made when the watch was on `from`) is still on it.
+void NoGood::watch(int w,trail<TLCNode*>& h,int from)
+{
+   if ((TLCNode*)h != nullptr) {
+      if (w == from)
+         return;
+      ((TLCNode*)h)->detach();
+   }
+   h = _x[w]->propagateOnBind(this);
+}
+
+void NoGood::propagate()
 {
    const long n = _x.size();
+   const int fromL = _wL,fromR = _wR;
    int i = _wL;
    while (i < n && _x[i]->isBound()) {
-      if (_x[i]->isTrue()) {
+      if (_x[i]->min() != _v[i]) {
          setActive(false);
          return;
       }
@@ -633,7 +747,7 @@ void Clause::propagate()
    _wL = i;
    i = _wR;
    while (i>=0 && _x[i]->isBound()) {
-      if (_x[i]->isTrue()) {
+      if (_x[i]->min() != _v[i]) {
          setActive(false);
          return;
       }
@@ -642,34 +756,153 @@ void Clause::propagate()
    _wR = i;
    if (_wL > _wR) failNow();
    else if (_wL == _wR) {
-      _x[_wL]->assign(true);
+      _x[_wL]->remove(_v[_wL]);
+      setActive(false);
+   } else {
+      watch(_wL,_hL,fromL);
+      watch(_wR,_hR,fromR);
+   }
+}
+
+Clause::Clause(const std::vector<var<bool>::Ptr>& x)
+   : Clause(x,{})
+{}
+
+static CPSolver::Ptr solverOf(const std::vector<var<bool>::Ptr>& x,const std::vector<var<bool>::Ptr>& y)
+{
+   return (x.size() ? x[0] : y[0])->getSolver();
+}
+
+Clause::Clause(const std::vector<var<bool>::Ptr>& x,const std::vector<var<bool>::Ptr>& y)
+   : Constraint(solverOf(x,y)),
+     _wL(solverOf(x,y)->getStateManager(),0),
+     _wR(solverOf(x,y)->getStateManager(),0),
+     _hL(solverOf(x,y)->getStateManager(),nullptr),
+     _hR(solverOf(x,y)->getStateManager(),nullptr)
+{
+   setPriority(LINEAR);
+   for(auto xi : x) {
+      _x.push_back(xi);
+      _neg.push_back(false);
+   }
+   for(auto yi : y) {
+      _x.push_back(yi);
+      _neg.push_back(true);
+   }
+}
+
+void Clause::post()
+{
+   const int n = (int)_x.size();
+   int w[2],nw = 0;
+   for(int i = 0;i < n && nw < 2;i++) {
+      if (isTrue(i)) {
+         setActive(false);
+         return;
+      } else if (!isFalse(i))
+         w[nw++] = i;
+   }
+   if (nw == 0)
+      failNow();
+   else if (nw == 1) {
+      _x[w[0]]->assign(!_neg[w[0]]);
       setActive(false);
    } else {
-      assert(_wL != _wR);
-      assert(!_x[_wL]->isBound());
-      assert(!_x[_wR]->isBound());
-      _x[_wL]->propagateOnBind(this);
-      _x[_wR]->propagateOnBind(this);
+      _wL = w[0];
+      _wR = w[1];
+      _hL = _x[w[0]]->propagateOnBind(this);
+      _hR = _x[w[1]]->propagateOnBind(this);
    }
 }
 
+// Moves the watch `w` (subscribed with `h`) off a false literal. The replacement is the next literal
+// (circularly) that is not false, other than the `other` watched literal. Without replacement, the
+// `other` literal must hold. Returns false once the clause is satisfied.
+bool Clause::rewatch(trail<int>& w,trail<TLCNode*>& h,int other)
+{
+   const int n = (int)_x.size();
+   const int from = w;
+   if (!_x[from]->isBound())
+      return true;
+   if (isTrue(from)) {
+      setActive(false);
+      return false;
+   }
+   for(int k = 1;k < n;k++) {
+      const int i = (from + k) % n;
+      if (i == other || isFalse(i))
+         continue;
+      if (isTrue(i)) {
+         setActive(false);
+         return false;
+      }
+      ((TLCNode*)h)->detach();
+      w = i;
+      h = _x[i]->propagateOnBind(this);
+      return true;
+   }
+   if (isFalse(other))
+      failNow();
+   _x[other]->assign(!_neg[other]);
+   setActive(false);
+   return false;
+}
+
+void Clause::propagate()
+{
+   if (rewatch(_wL,_hL,_wR))
+      rewatch(_wR,_hR,_wL);
+}
+
+// The clause only enforces a literal once all the others are false
+bool Clause::explain(const Literal& l,std::vector<Literal>& reason)
+{
+   for(auto i = 0u;i < _x.size();i++)
+      if (isFalse(i))
+         reason.push_back(_x[i]->literal(Literal::EQ,_neg[i]));
+   return true;
+}
+
 IsClause::IsClause(var<bool>::Ptr b,const std::vector<var<bool>::Ptr>& x)
    : Constraint(x[0]->getSolver()),
      _b(b),
-     _unBounds(x.size()),
-     _nUnBounds(x[0]->getSolver()->getStateManager(),(int)x.size())
+     _nUnBounds(x[0]->getSolver()->getStateManager(),(int)x.size()),
+     _sat(x[0]->getSolver()->getStateManager(),false)
 {
+   setPriority(LINEAR);
    for(auto xi : x) _x.push_back(xi);
-   for(auto i = 0u; i < _x.size();i++)
-      _unBounds[i] = i;
    _clause = new (x[0]->getSolver()) Clause(x);
 }
 
 void IsClause::post()
 {
-   _b->propagateOnBind(this);
-   for(auto& xi : _x)
-      xi->propagateOnBind(this);
+   int nU = 0;
+   for(auto& xi : _x) {
+      if (xi->isTrue()) {
+         _b->assign(true);
+         setActive(false);
+         return;
+      }
+      nU += !xi->isBound();
+   }
+   _nUnBounds = nU;
+   propagate();
+   if (isActive()) {
+      _b->propagateOnBind(this);
+      for(auto i = 0u;i < _x.size();i++)
+         if (!_x[i]->isBound())
+            _x[i]->adviseOnBoundChange(this,i);
+   }
+}
+
+bool IsClause::advise(int,const IntDelta& d)
+{
+   if (d.newMin() == 1) {
+      _sat = true;
+      return true;
+   }
+   _nUnBounds -= 1;
+   return _nUnBounds == 0;
 }
 
 void IsClause::propagate()
@@ -682,27 +915,12 @@ void IsClause::propagate()
       for(auto& xi : _x)
          xi->assign(false);
       setActive(false);
-   } else {
-      int nU = _nUnBounds;
-      for(int i = nU - 1;i >=0;i--) {
-         int idx = _unBounds[i];
-         auto y = _x[idx];
-         if (y->isBound()) {
-            if (y->isTrue()) {
-               _b->assign(true);
-               setActive(false);
-               return;
-            }
-            _unBounds[i] = _unBounds[nU -1];
-            _unBounds[nU - 1] = idx;
-            nU--;
-         }
-      }
-      if (nU == 0) {
-         _b->assign(false);
-         setActive(false);
-      }
-      _nUnBounds = nU;
+   } else if (_sat) {
+      _b->assign(true);
+      setActive(false);
+   } else if (_nUnBounds == 0) {
+      _b->assign(false);
+      setActive(false);
    }
 }
 
@@ -767,9 +985,12 @@ void AllDifferentAC::propagate()
       Factory::Veci::pointer x = _x.data();
       for(int i=0;i < _nVar;i++) {
          const int ub = x[i]->max();
+         _lost.clear();
          for(int v = x[i]->min(); v <= ub;++v)
             if (_match[i] != v && scc[i] != scc[valNode(v)] && x[i]->containsBase(v))
-               x[i]->remove(v);
+               _lost.push_back(v);
+         if (!_lost.empty())
+            x[i]->removeSet(_lost);
       }
    }
 }
@@ -826,6 +1047,7 @@ Element2D::Element2D(const Matrix<int,2>& mat,var<int>::Ptr x,var<int>::Ptr y,va
      _low(x->getSolver()->getStateManager(),0),
      _up(x->getSolver()->getStateManager(),_n * _m - 1)
 {
+   setPriority(LINEAR);
    for(int i=0;i < _matrix.size(0);i++)
       for(int j=0;j < _matrix.size(1);j++)
          _xyz.push_back(Triplet(i,j,_matrix[i][j]));
@@ -877,6 +1099,8 @@ void Element2D::propagate()
    _z->updateBounds(_xyz[l].z,_xyz[u].z);
    _low = l;
    _up  = u;
+   if (_x->isBound() && _y->isBound() && _z->isBound())
+      setActive(false);
 }
 
 void Element2D::print(std::ostream& os) const
@@ -889,6 +1113,7 @@ Element1DBasic::Element1DBasic(const std::vector<int>& array,var<int>::Ptr y,var
      _from(_y->getSolver()->getStateManager(),-1),
      _to(_y->getSolver()->getStateManager(),-1) // z == array[y]
 {
+   setPriority(LINEAR);
    _kv = NULL;
 }
 
@@ -932,9 +1157,10 @@ void Element1DBasic::post()
 
 void Element1DBasic::propagate() 
 {
-   if (_y->isBound())
+   if (_y->isBound()) {
       _z->assign(_t[_y->min()]);
-   else {
+      setActive(false);
+   } else {
       int k = _from;
       while (k < (int)_t.size() && !_y->contains(_kv[k]._k)) ++k;
       if (k < (int)_t.size()) {
@@ -958,6 +1184,14 @@ void Element1DBasic::propagate()
    }
 }
 
+// The index is filtered on its domain, the value on its bounds
+bool Element1DBasic::explain(const Literal& l,std::vector<Literal>& reason)
+{
+   LCG::domain(_y,reason);
+   LCG::bounds(_z,reason);
+   return true;
+}
+
 void Element1DBasic::print(std::ostream& os) const 
 {
    os << "element1DBasic(" << _t << ',' << _y << ',' << _z << ')' << std::endl;
@@ -965,7 +1199,9 @@ void Element1DBasic::print(std::ostream& os) const
 
 Element1DDC::Element1DDC(const std::vector<int>& array,var<int>::Ptr y,var<int>::Ptr z)
    : Constraint(y->getSolver()),_t(array),_y(y),_z(z)
-{}
+{
+   setPriority(LINEAR);
+}
 
 int Element1DDC::findIndex(int target) const
 {
@@ -1065,40 +1301,47 @@ void Element1DDC::post()
   _z->propagateOnDomainChange(this);
 }
 
-void Element1DDC::zLostValue(int v)
+void Element1DDC::zLostValue(int v)  // the supports of v left in D(y) go to _yLost
 {
   int k = findIndex(v);
   int link = _values[k]._k;
   while (link != _endOfList) {
-    _y->remove(link);
+    if (_y->contains(link))
+      _yLost.push_back(link);
     //assert(0 <= link && link < _yMax -_yMin + 1);
     link = _list[link-_yMin];
   }
 }
 
-void Element1DDC::yLostValue(int v)
+void Element1DDC::yLostValue(int v)  // a value of z without support left goes to _zLost
 {
   int k = findIndex(_t[v]);
   _values[k]._s--;
   if (_values[k]._s == 0)
-    _z->remove(_values[k]._v);
+    _zLost.push_back(_values[k]._v);
 }
 
 void Element1DDC::propagate() 
 {
   NoNotify nn;
+  _yLost.clear();
   for(int i=_zOld->min(); i <= _zOld->max();i++) {
     if (_zOld->member(i) && !_z->contains(i)) { // i was lost from D(z) but we didn't know that -> value Lost Event
       zLostValue(i);
       _zOld->remove(i,nn);
     }
   }
+  if (!_yLost.empty())
+    _y->removeSet(_yLost);
+  _zLost.clear();
   for(int i=_yOld->min();i <= _yOld->max();i++) {
     if (_yOld->member(i) && !_y->contains(i)) {
       yLostValue(i);
       _yOld->remove(i,nn);
     }
   }
+  if (!_zLost.empty())
+    _z->removeSet(_zLost);
 }
 
 void Element1DDC::print(std::ostream& os) const 
@@ -1151,6 +1394,8 @@ void Element1DVar::equalityPropagate()
    auto tVar = _array[_y->min()];
    tVar->updateBounds(_zMin,_zMax);
    _z->updateBounds(tVar->min(),tVar->max());
+   if (_z->isBound())
+      setActive(false);
 }
 
 void Element1DVar::filterY()
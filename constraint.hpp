@@ -34,7 +34,7 @@ class EQc : public Constraint { // x == c
    var<int>::Ptr _x;
    int           _c;
 public:
-   EQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) {}
+   EQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) { setPriority(UNARY);}
    void post() override;
 };
 
@@ -46,13 +46,14 @@ public:
    EQc* create() override;
    EQcDesc* clone() override;
    void print(std::ostream& os) const override;
+   bool literal(Literal& l) const override;
 };
 
 class NEQc : public Constraint { // x != c
    var<int>::Ptr _x;
    int           _c;
 public:
-   NEQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) {}
+   NEQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) { setPriority(UNARY);}
    void post() override;
 };
 
@@ -64,14 +65,54 @@ public:
    NEQc* create() override;
    NEQcDesc* clone() override;
    void print(std::ostream& os) const override;
+   bool literal(Literal& l) const override;
+};
+
+class LEQc : public Constraint { // x <= c
+   var<int>::Ptr _x;
+   int           _c;
+public:
+   LEQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) { setPriority(UNARY);}
+   void post() override;
+};
+
+class LEQcDesc : public ConstraintDesc {
+   var<int>::Ptr _x;
+   int           _c;
+public:
+   LEQcDesc(var<int>::Ptr x,int c) : _x(x), _c(c) {}
+   LEQc* create() override;
+   LEQcDesc* clone() override;
+   void print(std::ostream& os) const override;
+   bool literal(Literal& l) const override;
+};
+
+class GEQc : public Constraint { // x >= c
+   var<int>::Ptr _x;
+   int           _c;
+public:
+   GEQc(var<int>::Ptr x,int c) : Constraint(x->getSolver()),_x(x),_c(c) { setPriority(UNARY);}
+   void post() override;
+};
+
+class GEQcDesc : public ConstraintDesc {
+   var<int>::Ptr _x;
+   int           _c;
+public:
+   GEQcDesc(var<int>::Ptr x,int c) : _x(x), _c(c) {}
+   GEQc* create() override;
+   GEQcDesc* clone() override;
+   void print(std::ostream& os) const override;
+   bool literal(Literal& l) const override;
 };
 
 class EQBinBC : public Constraint { // x == y + c
    var<int>::Ptr _x,_y;
    int _c;
+   template <class X,class Y> void post(X* x,Y* y);
 public:
    EQBinBC(var<int>::Ptr x,var<int>::Ptr y,int c)
-      : Constraint(x->getSolver()),_x(x),_y(y),_c(c) {}
+      : Constraint(x->getSolver()),_x(x),_y(y),_c(c) { setPriority(BINARY);}
    void post() override;
 };
 
@@ -80,7 +121,7 @@ class EQTernBC : public Constraint { // x == y + z
   var<int>::Ptr _x,_y,_z;
 public:
    EQTernBC(var<int>::Ptr x,var<int>::Ptr y,var<int>::Ptr z)
-       : Constraint(x->getSolver()),_x(x),_y(y),_z(z) {}
+       : Constraint(x->getSolver()),_x(x),_y(y),_z(z) { setPriority(BINARY);}
    void post() override;
 };
 
@@ -89,7 +130,7 @@ class EQTernBCbool : public Constraint { // x == y + b
   var<bool>::Ptr _b;
 public:
   EQTernBCbool(var<int>::Ptr x,var<int>::Ptr y,var<bool>::Ptr b)
-    : Constraint(x->getSolver()),_x(x),_y(y),_b(b) {}
+    : Constraint(x->getSolver()),_x(x),_y(y),_b(b) { setPriority(BINARY);}
   void post() override;
 };
 
@@ -100,7 +141,7 @@ class NEQBinBC : public Constraint { // x != y + c
    void print(std::ostream& os) const override;
 public:
    NEQBinBC(var<int>::Ptr& x,var<int>::Ptr& y,int c)
-      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) {}
+      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) { setPriority(BINARY);}
    void post() override;
 };
 
@@ -110,7 +151,7 @@ class NEQBinBCLight : public Constraint { // x != y + c
    void print(std::ostream& os) const override;
 public:
    NEQBinBCLight(var<int>::Ptr& x,var<int>::Ptr& y,int c=0)
-      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) {}
+      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
@@ -120,7 +161,7 @@ class EQBinDC : public Constraint { // x == y + c
    int _c;
 public:
    EQBinDC(var<int>::Ptr& x,var<int>::Ptr& y,int c)
-      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) {}
+      : Constraint(x->getSolver()), _x(x),_y(y),_c(c) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
@@ -129,18 +170,21 @@ class Conjunction :public Constraint { // z == x && y
    var<bool>::Ptr _z,_x,_y;
 public:
    Conjunction(var<bool>::Ptr z,var<bool>::Ptr x,var<bool>::Ptr y)
-      : Constraint(x->getSolver()),_z(z),_x(x),_y(y) {}
+      : Constraint(x->getSolver()),_z(z),_x(x),_y(y) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
 
 class LessOrEqual :public Constraint { // x <= y
    var<int>::Ptr _x,_y;
+   IntVarImpl*   _cx,*_cy;   // see concrete
+   template <class X,class Y> void propagate(X* x,Y* y);
 public:
    LessOrEqual(var<int>::Ptr x,var<int>::Ptr y)
-      : Constraint(x->getSolver()),_x(x),_y(y) {}
+      : Constraint(x->getSolver()),_x(x),_y(y),_cx(concrete(x)),_cy(concrete(y)) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
+   bool explain(const Literal& l,std::vector<Literal>& reason) override;
 };
 
 class IsEqual : public Constraint { // b <=> x == c
@@ -149,7 +193,7 @@ class IsEqual : public Constraint { // b <=> x == c
    int _c;
 public:
    IsEqual(var<bool>::Ptr b,var<int>::Ptr x,int c)
-      : Constraint(x->getSolver()),_b(b),_x(x),_c(c) {}
+      : Constraint(x->getSolver()),_b(b),_x(x),_c(c) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
@@ -158,7 +202,7 @@ class XOR : public Constraint { // b <=> x xor y
    var<bool>::Ptr _b, _x, _y;
 public:
    XOR(var<bool>::Ptr b,var<bool>::Ptr x,var<bool>::Ptr y)
-      : Constraint(x->getSolver()),_b(b),_x(x),_y(y) {}
+      : Constraint(x->getSolver()),_b(b),_x(x),_y(y) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
@@ -169,7 +213,7 @@ class IsMember : public Constraint { // b <=> x in S
    std::set<int> _S;
 public:
    IsMember(var<bool>::Ptr b,var<int>::Ptr x,std::set<int> S)
-      : Constraint(x->getSolver()),_b(b),_x(x),_S(S) {}
+      : Constraint(x->getSolver()),_b(b),_x(x),_S(S) { setPriority(BINARY);}
    void post() override;
    void propagate() override;
 };
@@ -180,22 +224,33 @@ class IsLessOrEqual : public Constraint { // b <=> x <= c
    int _c;
 public:
    IsLessOrEqual(var<bool>::Ptr b,var<int>::Ptr x,int c)
-      : Constraint(x->getSolver()),_b(b),_x(x),_c(c) {}
+      : Constraint(x->getSolver()),_b(b),_x(x),_c(c) { setPriority(BINARY);}
    void post() override;
 };
 
+/**
+ * @brief Bound consistent sum. The sums of the lower and upper bounds of the terms are
+ * maintained by advisors (one delta per bound update) rather than recomputed by every propagation.
+ */
 class Sum : public Constraint { // s = Sum({x0,...,xk})
    Factory::Veci _x;
+   std::vector<IntVarImpl*> _cx;   // concrete(x[i]): the bounds of those are narrowed without virtual calls
    trail<int>    _nUnBounds;
-   trail<int>    _sumBounds;
+   trail<int>    _sumMin,_sumMax;
    unsigned int _n;
    std::vector<unsigned long> _unBounds;
+   template <class V> bool narrow(V* x) {  // the advisors keep _sumMin and _sumMax in sync with x
+      x->removeAbove(x->min() - _sumMin);
+      x->removeBelow(x->max() - _sumMax);
+      return x->isBound();
+   }
 public:
    template <class Vec> Sum(const Vec& x,var<int>::Ptr s)
        : Constraint(s->getSolver()),
          _x(x.size() + 1,Factory::alloci(s->getStore())), 
          _nUnBounds(s->getSolver()->getStateManager(),(int)x.size()+1),
-         _sumBounds(s->getSolver()->getStateManager(),0),
+         _sumMin(s->getSolver()->getStateManager(),0),
+         _sumMax(s->getSolver()->getStateManager(),0),
          _n((int)x.size() + 1),
          _unBounds(_n)
     {
@@ -203,11 +258,18 @@ public:
        for(auto& xi : x)
           _x[i++] = xi;
        _x[_n-1] = Factory::minus(s);
-       for(typename Vec::size_type i=0;i < _n;i++)
+       setPriority(LINEAR);
+       for(typename Vec::size_type i=0;i < _n;i++) {
           _unBounds[i] = i;
+          _cx.push_back(concrete(_x[i]));
+       }
+       s->getSolver()->getStateManager()->track(_unBounds.data(),_n * sizeof(unsigned long));
     }
    void post() override;
    void propagate() override;
+   bool advise(int idx,const IntDelta& d) override;
+   bool explain(const Literal& l,std::vector<Literal>& reason) override;
+   bool explainFailure(std::vector<Literal>& reason) override { return explain(Literal(),reason);}
 };
 
 class SumBool : public Constraint {
@@ -222,6 +284,7 @@ public:
         _nbOne(x[0]->getSolver()->getStateManager(),0),
         _nbZero(x[0]->getSolver()->getStateManager(),0)
    {
+       setPriority(LINEAR);
        int i = 0;
        for(auto& xi : x)
           _x[i++] = xi;      
@@ -230,25 +293,68 @@ public:
    void post() override;
 };
 
-class Clause : public Constraint { // x0 OR x1 .... OR xn
+/**
+ * @brief A clause \f$\bigvee_i l_i\f$ over boolean literals (\f$x_i\f$ or \f$\neg x_i\f$).
+ *
+ * Watched literals: the constraint only subscribes to the binding of two literals that are not false.
+ * When a watched literal becomes false, its subscription moves to another literal that is not false.
+ * When none is left, the other watched literal is forced to true.
+ */
+class Clause : public Constraint {
    std::vector<var<bool>::Ptr> _x;
-   trail<int> _wL,_wR;
+   std::vector<bool>           _neg;   // literal i is the negation of _x[i]
+   trail<int>      _wL,_wR;            // the watched literals
+   trail<TLCNode*> _hL,_hR;            // their subscriptions
+   bool isTrue(int i) const  { return _x[i]->isBound() && _x[i]->min() != _neg[i];}
+   bool isFalse(int i) const { return _x[i]->isBound() && _x[i]->min() == _neg[i];}
+   bool rewatch(trail<int>& w,trail<TLCNode*>& h,int other);
 public:
+   /**
+    * The clause \f$x_0 \vee \cdots \vee x_n\f$.
+    */
    Clause(const std::vector<var<bool>::Ptr>& x);
-   void post() override { propagate();}
+   /**
+    * The clause \f$x_0 \vee \cdots \vee x_n \vee \neg y_0 \vee \cdots \vee \neg y_m\f$.
+    */
+   Clause(const std::vector<var<bool>::Ptr>& x,const std::vector<var<bool>::Ptr>& y);
+   void post() override;
    void propagate() override;
+   bool explain(const Literal& l,std::vector<Literal>& reason) override;
 };
 
-class IsClause : public Constraint { // b <=> x0 OR .... OR xn
+/**
+ * @brief Reified clause \f$b \Leftrightarrow x_0 \vee \cdots \vee x_n\f$.
+ *
+ * While \f$b\f$ is unbound, advisors count the literals that are not false and only wake the propagator
+ * when one becomes true or when all are false. Once \f$b\f$ is true, the watched Clause takes over.
+ */
+class IsClause : public Constraint {
    var<bool>::Ptr _b;
    std::vector<var<bool>::Ptr> _x;
-   std::vector<int> _unBounds;
    trail<int>      _nUnBounds;
+   trail<bool>     _sat;
    Clause::Ptr        _clause;
 public:
    IsClause(var<bool>::Ptr b,const std::vector<var<bool>::Ptr>& x);
    void post() override;
    void propagate() override;
+   bool advise(int idx,const IntDelta& d) override;
+};
+
+/**
+ * @brief A nogood: the decisions \f$x_i = v_i\f$ cannot all hold, i.e., \f$\bigvee_i x_i \neq v_i\f$.
+ * It watches the two outermost literals that are not yet false.
+ */
+class NoGood : public Constraint {
+   std::vector<var<int>::Ptr> _x;
+   std::vector<int>           _v;
+   trail<int>      _wL,_wR;   // the watched decisions
+   trail<TLCNode*> _hL,_hR;   // their subscriptions
+   void watch(int w,trail<TLCNode*>& h,int from);
+public:
+   NoGood(const std::vector<var<int>::Ptr>& x,const std::vector<int>& v);
+   void post() override { propagate();}
+   void propagate() override;
 };
 
 class AllDifferentBinary :public Constraint {
@@ -272,13 +378,14 @@ class AllDifferentAC : public Constraint {
    int* _match,*_varFor;
    int _minVal,_maxVal;
    int _nVar,_nVal,_nNodes;
+   std::vector<int> _lost;   // the values propagate removes from a variable
    int updateRange();
    int valNode(int vid) const noexcept { return vid - _minVal + _nVar;}
 public:
    template <class Vec> AllDifferentAC(const Vec& x)
       : Constraint(x[0]->getSolver()),
         _x(x.begin(),x.end(),Factory::alloci(x[0]->getStore())),
-        _mm(_x,x[0]->getStore()) {}
+        _mm(_x,x[0]->getStore()) { setPriority(GLOBAL);setIdempotent(true);}
    ~AllDifferentAC() {}
    void post() override;
    void propagate() override;
@@ -309,6 +416,7 @@ class Minimize : public Objective {
    var<int>::Ptr _obj;
    int        _primal;
    int        _dual;
+   Incumbent::Ptr _shared;
    void print(std::ostream& os) const;
 public:
    Minimize(var<int>::Ptr& x);
@@ -321,12 +429,14 @@ public:
    int primal() const override { return _primal; }
    double optimalityGap() const override { return static_cast<double>(_primal-_dual)/_primal; }
    bool isMin() const override { return true; }
+   void share(Incumbent::Ptr inc) override { _shared = inc;}
 };
 
 class Maximize : public Objective {
    var<int>::Ptr _obj;
    int        _primal;
    int        _dual;
+   Incumbent::Ptr _shared;
    void print(std::ostream& os) const;
 public:
    Maximize(var<int>::Ptr& x);
@@ -339,6 +449,7 @@ public:
    int primal() const override { return _primal; }
    double optimalityGap() const override { return static_cast<double>(_dual-_primal)/_dual; }
    bool isMin() const override { return false; }
+   void share(Incumbent::Ptr inc) override { _shared = inc;}
 };
 
 class Element2D : public Constraint {
@@ -389,6 +500,8 @@ public:
    Element1DBasic(const std::vector<int>& array,var<int>::Ptr y,var<int>::Ptr z);
    void post() override;
    void propagate() override;
+   bool explain(const Literal& l,std::vector<Literal>& reason) override;
+   bool explainFailure(std::vector<Literal>& reason) override { return explain(Literal(),reason);}
    void print(std::ostream& os) const override;
 };
 
@@ -408,6 +521,7 @@ class Element1DDC : public Constraint { // z =DC= t[y] (Domain consistent versio
    int            _nbv; // number of values in _values
    int     _yMin,_yMax;
    BitDomain::Ptr _zOld,_yOld;
+   std::vector<int> _yLost,_zLost; // the values propagate removes from D(y) and D(z) at once
    int findIndex(int target) const;
    void zLostValue(int v);
    void yLostValue(int v);
@@ -434,6 +548,7 @@ public:
         _z(z),
         _yValues(_y->size())
    {
+      setPriority(LINEAR);
       for(auto i = 0u;i < array.size();i++)
          _array[i] = array[i];
    }
@@ -445,7 +560,7 @@ class EQAbsDiffBC : public Constraint { // z == |x - y|
   var<int>::Ptr _z,_x,_y;
 public:
   EQAbsDiffBC(var<int>::Ptr z,var<int>::Ptr x,var<int>::Ptr y)
-       : Constraint(x->getSolver()),_z(z),_x(x),_y(y) {}
+       : Constraint(x->getSolver()),_z(z),_x(x),_y(y) { setPriority(BINARY);}
    void post() override;
 };
 
@@ -499,6 +614,22 @@ namespace Factory
       return new (x->getSolver()) NEQcDesc(x,c);
       //return nullptr;
    }
+   /**
+    * Factory function to rebuild a decision from its solver-independent description
+    * @param cp the solver holding the variable designated by the literal
+    * @param l the literal (e.g., recorded in another solver built by the same model code)
+    * @return the constraint `x op v` on the variable of `cp` that has the identifier of `l`
+    * @see Literal, CPSolver::recordDecisions
+    */
+   inline ConstraintDesc::Ptr decision(CPSolver::Ptr cp,const Literal& l) {
+      var<int>::Ptr x = static_cast<var<int>*>(cp->varAt(l._var).get());
+      switch(l._rel) {
+         case Literal::EQ:  return new (cp) EQcDesc(x,l._val);
+         case Literal::NEQ: return new (cp) NEQcDesc(x,l._val);
+         case Literal::LEQ: return new (cp) LEQcDesc(x,l._val);
+         default:           return new (cp) GEQcDesc(x,l._val);
+      }
+   }
    /**
     * Factory function to create the constraint \f$x \in S\f$
     * @param x the variable
@@ -659,26 +790,20 @@ namespace Factory
     * @param x an integer variable
     * @param c a constant integer
     * @return the constraint \f$x \leq c\f$
-    * Note: this does not really allocate a constraint. It does the job inline on the variable directly.
+    * @see LEQc
     */
-   inline Constraint::Ptr operator<=(var<int>::Ptr x,const int c) {
-      auto cp = x->getSolver();
-      x->removeAbove(c);
-      cp->fixpoint();
-      return nullptr;
+   inline ConstraintDesc::Ptr operator<=(var<int>::Ptr x,const int c) {
+      return new (x->getSolver()) LEQcDesc(x,c);
    }
    /**
     * Factory function to create the constraint \f$x \geq c\f$
     * @param x an integer variable
     * @param c a constant integer
     * @return the constraint \f$x \geq c\f$
-    * Note: this does not really allocate a constraint. It does the job inline on the variable directly.
+    * @see GEQc
     */
-   inline Constraint::Ptr operator>=(var<int>::Ptr x,const int c) {
-      auto cp = x->getSolver();
-      x->removeBelow(c);
-      cp->fixpoint();
-      return nullptr;
+   inline ConstraintDesc::Ptr operator>=(var<int>::Ptr x,const int c) {
+      return new (x->getSolver()) GEQcDesc(x,c);
    }
    /**
     * Factory function to create the constraint \f$x \leq c\f$
@@ -1000,6 +1125,16 @@ namespace Factory
    inline Constraint::Ptr clause(std::initializer_list<var<bool>::Ptr> init) {
      return new ((*init.begin())->getSolver()) Clause(init);    
    }
+   /**
+    * Factory function that creates a nogood over decisions
+    * @param x a vector of `n` variables
+    * @param v a vector of `n` values
+    * @return a constraint representing \f$ \bigvee_{i=0}^n x_i \neq v_i \f$
+    * @see NoGood
+    */
+   inline Constraint::Ptr nogood(const std::vector<var<int>::Ptr>& x,const std::vector<int>& v) {
+      return new (x[0]->getSolver()) NoGood(x,v);
+   }
    /**
     * Factory reification function that returns a constraint requiring `b` to be true if the clause over `xs` is true
     * @param b a Boolean variable
@@ -16,103 +16,141 @@
 #include "domain.hpp"
 #include "fail.hpp"
 #include <iostream>
+#include <algorithm>
 
 #if defined(_WIN64)
 #include <intrin.h>
 #endif
 
-BitDomain::BitDomain(Trailer::Ptr eng,Storage::Ptr store,int min,int max)
-    : _min(eng,min),
-      _max(eng,max),
-      _sz(eng,max - min + 1),
-      _imin(min)
-{
-   const int nb = (_sz >> 5) + ((_sz & 0x1f) != 0); // number of 32-bit words
-   _dom = (trail<int>*)store->allocate(sizeof(trail<int>) * nb); // allocate storage from stack allocator
-   for(int i=0;i<nb;i++)
-      new (_dom+i) trail<int>(eng,0xffffffff);  // placement-new for each reversible.
-   const bool partial = _sz & 0x1f;
-   if (partial)
-      _dom[nb - 1] = _dom[nb - 1] & ~(0xffffffff << (max - min + 1) % 32);
-}
-
-int BitDomain::count(int from,int to) const
+static inline int popCount(unsigned long long w)
 {
-    from = from  - _imin;
-    to   = to - _imin + 1;
-    int fw = from >> 5,tw = to >> 5;
-    int fb = from & 0x1f,tb = to & 0x1f;
-    int nc = 0;
-    if (fw == tw) {
-        const unsigned int wm = (0xFFFFFFFF << fb) & ~(0xFFFFFFFF << tb);
-        const unsigned int bits = _dom[fw] & wm;
 #if defined(_WIN64)
-        nc = __popcnt(bits);
+    return (int)__popcnt64(w);
 #else
-        nc = __builtin_popcount(bits);
+    return __builtin_popcountll(w);
 #endif
-    } else {
-      unsigned int wm = (0xFFFFFFFF << fb);
-      unsigned int bits;
-      while (fw < tw) {
-          bits = _dom[fw] & wm;
+}
+
+// Index of the lowest bit set (w != 0)
+static inline int lowestBit(unsigned long long w)
+{
 #if defined(_WIN64)
-          nc += __popcnt(bits);
+    unsigned long at;
+    _BitScanForward64(&at,w);
+    return (int)at;
 #else
-          nc += __builtin_popcount(bits);
+    return __builtin_ctzll(w);
 #endif
-          fw += 1;
-          wm = 0xFFFFFFFF;
-      }
-      wm = ~(0xFFFFFFFF << tb);
-      bits = _dom[fw] & wm;
+}
+
+// Index of the highest bit set (w != 0)
+static inline int highestBit(unsigned long long w)
+{
 #if defined(_WIN64)
-      nc += __popcnt(bits);
+    unsigned long at;
+    _BitScanReverse64(&at,w);
+    return (int)at;
 #else
-      nc += __builtin_popcount(bits);
+    return 63 - __builtin_clzll(w);
 #endif
-    }
+}
+
+static const unsigned long long ALLONES = ~0ULL;
+
+BitDomain::BitDomain(Trailer::Ptr eng,Storage::Ptr store,int min,int max)
+    : _store(store),
+      _dom(eng,nullptr),
+      _base(eng,min),
+      _nbw(eng,0),
+      _min(eng,min),
+      _max(eng,max),
+      _sz(eng,max - min + 1)
+{}
+
+// Called on the first hole: the bitset spans the current bounds and holds all their values.
+// The words are fresh (their first write is not trailed) but backtracking past this point
+// also resets _dom and reclaims them.
+void BitDomain::makeBitset()
+{
+   const int span = _max - _min + 1;
+   const int nb = (span >> 6) + ((span & 0x3f) != 0); // number of 64-bit words
+   Trailer::Ptr eng = _sz.ctx();
+   trail<Word>* words = (trail<Word>*)_store->allocate(sizeof(trail<Word>) * nb); // allocate storage from stack allocator
+   for(int i=0;i<nb;i++)
+      new (words+i) trail<Word>(eng,ALLONES);  // placement-new for each reversible.
+   const int partial = span & 0x3f;
+   if (partial)
+      words[nb - 1] = ALLONES >> (64 - partial);
+   _base = _min.value();   // not the copy assignment of trail, which would skip the save
+   _nbw  = nb;
+   _dom  = words;
+}
+
+int BitDomain::count(int from,int to) const
+{
+    if (_dom == nullptr)
+        return to - from + 1;
+    const trail<Word>* dom = _dom;
+    from = from  - _base;
+    to   = to - _base + 1;
+    int fw = from >> 6,tw = to >> 6;
+    const int fb = from & 0x3f,tb = to & 0x3f;
+    if (fw == tw)
+        return popCount(dom[fw] & (ALLONES << fb) & ~(ALLONES << tb));
+    int nc = popCount(dom[fw] & (ALLONES << fb));
+    while (++fw < tw)
+        nc += popCount(dom[fw]);
+    if (tb)   // the last word is partial (it may lie past the end of the bitset otherwise)
+        nc += popCount(dom[tw] & ~(ALLONES << tb));
     return nc;
 }
 
+// The smallest value of the domain at or above `from` (there must be one)
 int BitDomain::findMin(int from) const
 {
-    from -= _imin;
-    int mw = from >> 5, mb = from & 0x1f;
-    unsigned int mask = 0x1 << mb;
-    while ((_dom[mw] & mask) == 0) {
-        mask <<= 1;
-        ++mb;
-        if (mask == 0) {
-            ++mw;
-            mb = 0;
-            mask = 0x1;
-        }
+    if (_dom == nullptr)
+        return from;
+    const trail<Word>* dom = _dom;
+    const int base = _base;
+    from -= base;
+    const int nbw = _nbw;
+    int mw = from >> 6;
+    if (mw >= nbw)
+        return base + (nbw << 6);
+    Word w = dom[mw] & (ALLONES << (from & 0x3f));
+    while (w == 0) {
+        if (++mw == nbw)    // no value left: past the end rather than past the bitset
+            return base + (nbw << 6);
+        w = dom[mw];
     }
-    return _imin  + ((mw << 5) + mb);
+    return base + ((mw << 6) + lowestBit(w));
 }
+
+// The largest value of the domain at or below `from` (there must be one)
 int BitDomain::findMax(int from) const
 {
-    from -= _imin;
-    int mw = from >> 5, mb = from & 0x1f;
-    unsigned int mask = 0x1 << mb;
-    while ((_dom[mw] & mask) == 0) {
-        mask >>= 1;
-        --mb;
-        if (mask == 0) {
-            --mw;
-            mb = 31;
-            mask = 0x80000000;
-        }
+    if (_dom == nullptr)
+        return from;
+    const trail<Word>* dom = _dom;
+    const int base = _base;
+    from -= base;
+    if (from < 0)
+        return base - 1;
+    int mw = from >> 6;
+    Word w = dom[mw] & (ALLONES >> (63 - (from & 0x3f)));
+    while (w == 0) {
+        if (mw-- == 0)      // no value left: before the start rather than before the bitset
+            return base - 1;
+        w = dom[mw];
     }
-    return _imin + ((mw << 5) + mb);
+    return base + ((mw << 6) + highestBit(w));
 }
 
 void BitDomain::assign(int v,IntNotifier& x)  // removeAllBut(v,x)
 {
     if (_sz == 1 && v == _min)
         return;
-    if (v < _min || v > _max || !GETBIT(v)) {
+    if (!member(v)) {
         _sz = 0;
         x.empty();
         return;
@@ -135,19 +173,20 @@ void BitDomain::remove(int v,IntNotifier& x)
         return;
     const bool minChanged = v == theMin;
     const bool maxChanged = v == theMax;
-    if (minChanged) {
-        const int sz = _sz -= 1;
-       _min = findMin(theMin + 1);
-        x.changeMin();
-        if (sz == 1) x.bind();
-        if (sz == 0) x.empty();
-        x.change();
-    } else if (maxChanged) {
+    if (minChanged || maxChanged) {
         const int sz = _sz -= 1;
-        _max = findMax(theMax - 1);
-        x.changeMax();
+        if (sz == 0) {      // v was the last value: there is nothing to scan for
+            x.empty();
+            return;
+        }
+        if (minChanged) {
+            _min = findMin(theMin + 1);
+            x.changeMin();
+        } else {
+            _max = findMax(theMax - 1);
+            x.changeMax();
+        }
         if (sz == 1) x.bind();
-        if (sz == 0) x.empty();
         x.change();
     } else if (member(v)) {
         setZero(v);
@@ -162,8 +201,10 @@ void BitDomain::removeBelow(int newMin,IntNotifier& x)
 {
     if (newMin <= _min)
         return;
-    if (newMin > _max)
+    if (newMin > _max) {
         x.empty();
+        return;
+    }
     bool isCompact = (_max - _min + 1) == _sz;
     int nbRemove = isCompact ? newMin - _min : count(_min,newMin - 1);
     _sz = _sz - nbRemove;
@@ -180,8 +221,10 @@ void BitDomain::removeAbove(int newMax,IntNotifier& x)
 {
     if (newMax >= _max)
         return;
-    if (newMax < _min)
+    if (newMax < _min) {
         x.empty();
+        return;
+    }
     bool isCompact = (_max - _min + 1) == _sz;
     int nbRemove = isCompact ? _max - newMax : count(newMax + 1,_max);
     _sz = _sz - nbRemove;
@@ -194,6 +237,129 @@ void BitDomain::removeAbove(int newMax,IntNotifier& x)
     if (_sz==1) x.bind();
 }
 
+// Notifies the change of a bulk operation (the size did change)
+void BitDomain::notify(int oldMin,int oldMax,IntNotifier& x)
+{
+    if (_min != oldMin) x.changeMin();
+    if (_max != oldMax) x.changeMax();
+    if (_sz == 1) x.bind();
+    x.change();
+}
+
+void BitDomain::removeSet(const std::vector<int>& vals,IntNotifier& x)
+{
+    const int oldMin = _min,oldMax = _max,oldSz = _sz;
+    int sz = oldSz;
+    bool minGone = false,maxGone = false;   // the bounds move rather than lose their bit
+    for(int v : vals) {
+        if (v < oldMin || v > oldMax)
+            continue;
+        if (v == oldMin) {
+            sz -= !minGone;
+            minGone = true;
+        } else if (v == oldMax) {
+            sz -= !maxGone;
+            maxGone = true;
+        } else if (_dom == nullptr || bit(v)) {
+            setZero(v);
+            --sz;
+        }
+    }
+    if (sz == oldSz)
+        return;
+    _sz = sz;
+    if (sz == 0) {
+        x.empty();
+        return;
+    }
+    if (minGone) _min = findMin(oldMin + 1);
+    if (maxGone) _max = findMax(oldMax - 1);
+    notify(oldMin,oldMax,x);
+}
+
+// The 64 bits of `mask` that stand for the values `from + off` to `from + off + 63` (0 past the mask)
+static inline unsigned long long maskBits(const unsigned long long* mask,int nbw,int off)
+{
+    const int q = off >= 0 ? off >> 6 : -((63 - off) >> 6);
+    const int s = off - q * 64;
+    unsigned long long w = 0;
+    if (q >= 0 && q < nbw)
+        w = mask[q] >> s;
+    if (s && q + 1 >= 0 && q + 1 < nbw)
+        w |= mask[q + 1] << (64 - s);
+    return w;
+}
+
+void BitDomain::intersectWith(int from,const unsigned long long* mask,int nbw,IntNotifier& x)
+{
+    const int oldMin = _min,oldMax = _max,oldSz = _sz;
+    const int lo = std::max(oldMin,from);
+    const int hi = (int)std::min((long long)oldMax,from + 64LL * nbw - 1);
+    if (lo > hi) {
+        _sz = 0;
+        x.empty();
+        return;
+    }
+    int sz = 0,first = 0,last = 0;
+    if (_dom == nullptr) {   // still an interval: it may stay one
+        for(int v0 = lo;v0 <= hi;v0 += 64) {
+            Word keep = maskBits(mask,nbw,v0 - from);
+            if (hi - v0 < 63)
+                keep &= ALLONES >> (63 - (hi - v0));
+            if (keep) {
+                if (sz == 0) first = v0 + lowestBit(keep);
+                last = v0 + highestBit(keep);
+                sz += popCount(keep);
+            }
+            if (hi - v0 < 64)
+                break;
+        }
+        if (sz > 0 && sz == last - first + 1) {
+            if (sz != oldSz) {
+                _min = first;
+                _max = last;
+                _sz  = sz;
+                notify(oldMin,oldMax,x);
+            }
+            return;
+        }
+        if (sz > 0)
+            makeBitset();
+        sz = 0;
+    }
+    if (_dom != nullptr) {
+        trail<Word>* dom = _dom;
+        const int base = _base;
+        const int fw = (lo - base) >> 6,lw = (hi - base) >> 6;
+        for(int w = fw;w <= lw;w++) {
+            const int v0 = base + (w << 6);
+            Word range = ALLONES;    // the bits of [lo,hi] in this word
+            if (w == fw) range &= ALLONES << ((lo - base) & 0x3f);
+            if (w == lw) range &= ALLONES >> (63 - ((hi - base) & 0x3f));
+            const Word old = dom[w];
+            const Word now = old & (maskBits(mask,nbw,v0 - from) | ~range);
+            if (now != old)
+                dom[w] = now;
+            const Word in = now & range;
+            if (in) {
+                if (sz == 0) first = v0 + lowestBit(in);
+                last = v0 + highestBit(in);
+                sz += popCount(in);
+            }
+        }
+    }
+    if (sz == oldSz)
+        return;
+    _sz = sz;
+    if (sz == 0) {
+        x.empty();
+        return;
+    }
+    _min = first;
+    _max = last;
+    notify(oldMin,oldMax,x);
+}
+
 std::ostream& operator<<(std::ostream& os,const BitDomain& x)
 {
     if (x.size()==1)
@@ -246,6 +412,8 @@ SparseSet::SparseSet(Trailer::Ptr eng,int n,int ofs)
 {
     for(int i=0;i < n;i++)
         _values[i] = _indexes[i] = i;
+    eng->track(_values.data(),n * sizeof(int));   // only the size is trailed: snapshots need the permutation too
+    eng->track(_indexes.data(),n * sizeof(int));
 }
 
 void SparseSet::exchangePositions(int val1,int val2)
@@ -17,12 +17,11 @@
 #define __BITDOMAIN_H
 
 #include <assert.h>
+#include <vector>
 #include "handle.hpp"
 #include "trailable.hpp"
 #include "store.hpp"
 
-#define GETBIT(b) ((_dom[((b) - _imin)>>5] & (0x1 << (((b)-_imin) & 0x1f)))!=0)
-
 struct IntNotifier   {
     virtual void empty() = 0;
     virtual void bind() = 0;
@@ -31,17 +30,40 @@ struct IntNotifier   {
     virtual void changeMax() = 0;
 };
 
+/**
+ * @brief Domain of an integer variable: its bounds, its size and, once it has a hole, a bitset of its values.
+ *
+ * The domain is a pure interval until a value strictly between the bounds is removed. Only then is
+ * the bitset allocated (on the Storage, so that backtracking reclaims it), in 64-bit words that span
+ * the bounds of that moment rather than the initial ones. Variables that only see bound changes
+ * (e.g., wide start times) never pay for a bitset.
+ *
+ * The bits outside of the bounds are stale: the bounds are updated without touching the words.
+ * Scans and counts work a word at a time (count leading/trailing zeros and population count)
+ * and every word is trailed at most once per choice point.
+ */
 class BitDomain {
-   trail<int>*               _dom;
-   trail<int>       _min,_max,_sz;
-   const int        _imin;
+   typedef unsigned long long Word;
+   Storage::Ptr                _store;
+   trail<trail<Word>*>           _dom;  // the bitset (nullptr while the domain is an interval)
+   trail<int>                   _base;  // the value of the first bit
+   trail<int>                    _nbw;  // the number of words of the bitset
+   trail<int>           _min,_max,_sz;
+   bool bit(int v) const noexcept {
+      v -= _base;
+      return ((_dom.value()[v >> 6] >> (v & 0x3f)) & 0x1) != 0;
+   }
+   void makeBitset();
+   void notify(int oldMin,int oldMax,IntNotifier& x);
    int count(int from,int to) const;
    int findMin(int from) const;
    int findMax(int from) const;
-   void setZero(int at) const noexcept {
-      at -= _imin;
-      const int mw = at >> 5,  mb = at & 0x1f;
-      _dom[mw] = _dom[mw] & ~(0x1 << mb);
+   void setZero(int at) noexcept {
+      if (_dom == nullptr)
+         makeBitset();
+      at -= _base;
+      trail<Word>& w = _dom.value()[at >> 6];
+      w = w & ~(Word(1) << (at & 0x3f));
    }
 public:
     typedef handle_ptr<BitDomain>  Ptr;
@@ -50,13 +72,31 @@ public:
     int max() const { return _max;}
     int size() const { return _sz;}
     bool isBound() const { return _sz == 1;}
-    bool member(int v) const noexcept { return _min <= v && v <= _max && GETBIT(v);}
-    bool memberBase(int v) const noexcept { return GETBIT(v);}
+    bool member(int v) const noexcept { return _min <= v && v <= _max && (_dom == nullptr || bit(v));}
+    /**
+     * @return true if `v` is in the domain, assuming it lies within the bounds
+     */
+    bool memberBase(int v) const noexcept { return _dom == nullptr || bit(v);}
+    /**
+     * @return true once the domain has a bitset (it had a hole on the current branch)
+     */
+    bool hasHoles() const noexcept { return _dom != nullptr;}
     bool changed() const noexcept { return !_sz.fresh();}
     void assign(int v,IntNotifier& x);
     void remove(int v,IntNotifier& x);
     void removeBelow(int newMin,IntNotifier& x);
     void removeAbove(int newMax,IntNotifier& x);
+    /**
+     * Removes the values of `vals` (in any order, those not in the domain are ignored) and
+     * notifies `x` once.
+     */
+    void removeSet(const std::vector<int>& vals,IntNotifier& x);
+    /**
+     * Keeps only the values whose bit is set in `mask` (value `from + i` is bit `i`), a word at a time,
+     * and notifies `x` once.
+     * @param nbw the number of words of `mask`
+     */
+    void intersectWith(int from,const unsigned long long* mask,int nbw,IntNotifier& x);
     friend std::ostream& operator<<(std::ostream& os,const BitDomain& x);
 };
 
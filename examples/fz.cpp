@@ -19,14 +19,22 @@
 #include "intvar.hpp"
 #include "constraint.hpp"
 #include "search.hpp"
+#include "psearch.hpp"
+#include "lcg.hpp"
+#include <fstream>
+#include <random>
 #include <fz_parser/flatzinc.h>
 #include <fz_constraints/flatzinc.hpp>
 #include <cxxopts.hpp>
 
 var<int>::Ptr makeIntVar(CPSolver::Ptr cp, FlatZinc::IntVar& fzIntVar);
 var<bool>::Ptr makeBoolVar(CPSolver::Ptr cp, FlatZinc::BoolVar& fzBoolVar);
+void makeModel(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars, SearchStatistics& search_statistics);
+Objective::Ptr makeObjective(FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars);
+ModelBuilder makeModelBuilder(FlatZinc::FlatZincModel* fzModel, bool portfolio, SearchStatistics* model_statistics = nullptr);
 std::function<Branches(void)> makeSearchHeuristic(CPSolver::Ptr cp, FlatZinc::SearchHeuristic& sh, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
-std::vector<std::function<Branches(void)>> makeSearchCombinator(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel,  std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
+std::vector<std::function<Branches(void)>> makeSearchCombinator(CPSolver::Ptr cp, std::vector<FlatZinc::SearchHeuristic> search_combinator,  std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
+std::function<Branches(void)> makePortfolioHeuristic(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars, int worker);
 Limit makeLimit(int solution_limit, int time_limit);
 
 void printFlatZincModel(FlatZinc::FlatZincModel* fzModel);
@@ -43,6 +51,14 @@ int main(int argc,char* argv[])
             ("s,", "Print search statistics", cxxopts::value<bool>()->default_value("false"))
             ("t,", "Stop search after 'arg' ms", cxxopts::value<int>()->default_value("1000000000"))
             ("v,", "Print log messages", cxxopts::value<bool>()->default_value("false"))
+            ("e,", "Embarrassingly parallel search with 'arg' threads", cxxopts::value<int>()->default_value("0"))
+            ("p,", "Portfolio of 'arg' threads with different heuristics", cxxopts::value<int>()->default_value("0"))
+            ("w,", "Work-stealing parallel search with 'arg' threads", cxxopts::value<int>()->default_value("0"))
+            ("eps-subproblems", "Decompose into at least 'arg' subproblems (default: 30 per thread)", cxxopts::value<int>()->default_value("0"))
+            ("eps-save", "Write the subproblems to file 'arg'", cxxopts::value<std::string>())
+            ("eps-load", "Read the subproblems from file 'arg' instead of decomposing", cxxopts::value<std::string>())
+            ("profile", "Profile the propagators and print the profile ('arg' is table or json) on stderr (sequential search only)", cxxopts::value<std::string>())
+            ("lcg", "Learn clauses from the conflicts (sequential search only)", cxxopts::value<bool>()->default_value("false"))
             ("fz", "FlatZinc", cxxopts::value<std::string>())
             ("h,help", "Print usage");
     options_parser.parse_positional({"fz"});
@@ -51,6 +67,19 @@ int main(int argc,char* argv[])
 
     if((not options.count("h")) and options.count("fz"))
     {
+        //The parallel searches run one solver per thread and do not support the per-solver options
+        bool const parallel = options["p"].as<int>() > 0 or options["e"].as<int>() > 0 or options["w"].as<int>() > 0;
+        if (parallel and options.count("profile"))
+        {
+            printError("--profile is only supported by the sequential search");
+            exit(EXIT_FAILURE);
+        }
+        if (parallel and options["lcg"].as<bool>())
+        {
+            printError("--lcg is only supported by the sequential search");
+            exit(EXIT_FAILURE);
+        }
+
         //Create statistics
         SearchStatistics search_statistics;
 
@@ -58,63 +87,93 @@ int main(int argc,char* argv[])
         FlatZinc::FlatZincModel * const fzModel = FlatZinc::parse(options["fz"].as<std::string>());
         TRACE(printFlatZincModel(fzModel));
 
-        //Create solver
-        CPSolver::Ptr cp = Factory::makeSolver();
-
-        //Create variables: no longer count the vars that are constant.
-        std::vector<var<int>::Ptr> int_vars;
-        size_t nbV = 0;
-        for(size_t i = 0; i < fzModel->int_vars.size(); i += 1) {
-           auto theVar = makeIntVar(cp, fzModel->int_vars[i]);
-           nbV += !theVar->isBound();
-           int_vars.push_back(theVar);
-        }
-        search_statistics.setIntVars(nbV);
-        std::vector<var<bool>::Ptr> bool_vars;
-        nbV = 0;
-        for(size_t i = 0; i < fzModel->bool_vars.size(); i += 1) {
-           auto theVar = makeBoolVar(cp, fzModel->bool_vars[i]);
-           nbV += !theVar->isBound();
-           bool_vars.push_back(theVar);
-        }
-        search_statistics.setBoolVars(nbV);
-
-        //Create and post constraints
-        search_statistics.setPropagators(fzModel->constraints.size());
-        for(size_t i = 0; i < fzModel->constraints.size(); i += 1)
-        {
-            cp->post(Factory::makeConstraint(cp, fzModel->constraints[i], int_vars, bool_vars));
-        }
-
-        //Create search combinator
-        std::vector<std::function<Branches(void)>> search_heuristics = makeSearchCombinator(cp, fzModel, int_vars, bool_vars);
-        DFSearch search(cp, land(search_heuristics));
-
         //Create search limit
         Limit search_limit = makeLimit(options.count("a") ? 1000000000 : options["n"].as<int>(), options["t"].as<int>());
 
-        //Output printing
-        search.onSolution([&](){
-           fzModel->print(std::cout, int_vars, bool_vars);
-           std::cout << "----------\n";
-        });
-
-        //Start search
-        search_statistics.setInitTime();
-        if (fzModel->method.type == FlatZinc::Method::Type::Minimization)
+        if (options["p"].as<int>() > 0)
         {
-            Objective::Ptr obj = Factory::minimize(int_vars[fzModel->objective_variable]);
-            search.optimize(obj, search_statistics, search_limit);
+            //Portfolio: every thread builds its own solver and searches with its own heuristic
+            PortfolioSearch search(makeModelBuilder(fzModel, true, &search_statistics), options["p"].as<int>());
+            search_statistics.setInitTime();
+            search.solve(search_statistics, search_limit);
         }
-        else if(fzModel->method.type == FlatZinc::Method::Type::Maximization)
+        else if (options["w"].as<int>() > 0)
         {
-            Objective::Ptr obj = Factory::maximize(int_vars[fzModel->objective_variable]);
-            search.optimize(obj, search_statistics, search_limit);
+            //Work stealing: every thread builds its own solver and idle threads steal subtrees from busy ones
+            ParallelDFSearch search(makeModelBuilder(fzModel, false, &search_statistics), options["w"].as<int>());
+            search_statistics.setInitTime();
+            search.solve(search_statistics, search_limit);
         }
-        else if (fzModel->method.type == FlatZinc::Method::Type::Satisfaction)
+        else if (options["e"].as<int>() > 0)
         {
+            //Embarrassingly parallel search: every thread builds its own solver
+            EPSearch search(makeModelBuilder(fzModel, false, &search_statistics), options["e"].as<int>());
+            if (options.count("eps-load"))
+            {
+                std::ifstream in(options["eps-load"].as<std::string>());
+                if (not search.load(in))
+                {
+                    printError("Malformed subproblems file");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else
+            {
+                int target = options["eps-subproblems"].as<int>();
+                search.decompose(target > 0 ? target : 30 * options["e"].as<int>(), search_statistics);
+            }
+            if (options.count("eps-save"))
+            {
+                std::ofstream out(options["eps-save"].as<std::string>());
+                search.save(out);
+            }
+            search_statistics.setInitTime();
             search.solve(search_statistics, search_limit);
         }
+        else
+        {
+            //Create solver
+            CPSolver::Ptr cp = Factory::makeSolver();
+            cp->setProfiling(options.count("profile"));
+            cp->setLearning(options["lcg"].as<bool>());
+
+            //Create variables and constraints
+            std::vector<var<int>::Ptr> int_vars;
+            std::vector<var<bool>::Ptr> bool_vars;
+            makeModel(cp, fzModel, int_vars, bool_vars, search_statistics);
+
+            //Create search combinator
+            std::vector<std::function<Branches(void)>> search_heuristics = makeSearchCombinator(cp, fzModel->search_combinator, int_vars, bool_vars);
+            DFSearch search(cp, land(search_heuristics));
+
+            //Output printing
+            search.onSolution([&](){
+               fzModel->print(std::cout, int_vars, bool_vars);
+               std::cout << "----------\n";
+            });
+
+            //Start search
+            search_statistics.setInitTime();
+            Objective::Ptr obj = makeObjective(fzModel, int_vars);
+            if (obj)
+            {
+                search.optimize(obj, search_statistics, search_limit);
+            }
+            else
+            {
+                search.solve(search_statistics, search_limit);
+            }
+            search_statistics.setPropagations(cp->getPropagations());
+            search_statistics.setAvoidedWakeups(cp->getAvoidedWakeups());
+            if (options.count("profile"))
+            {
+                cp->profiler()->print(std::cerr, options["profile"].as<std::string>() == "json" ? Profiler::JSON : Profiler::Table);
+            }
+            if (cp->learner() and options["s"].as<bool>())
+            {
+                std::cerr << cp->learner()->statistics();
+            }
+        }
 
         //Print termination line
         if (search_statistics.getCompleted())
@@ -133,7 +192,6 @@ int main(int argc,char* argv[])
         search_statistics.setSolveTime();
         if(options["s"].as<bool>())
         {
-            search_statistics.setPropagations(cp->getPropagations());
             std::cout << search_statistics;
         }
         exit(EXIT_SUCCESS);
@@ -166,9 +224,80 @@ var<bool>::Ptr makeBoolVar(CPSolver::Ptr cp, FlatZinc::BoolVar& fzBoolVar)
     }
 }
 
+void makeModel(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars, SearchStatistics& search_statistics)
+{
+    //Create variables: no longer count the vars that are constant.
+    size_t nbV = 0;
+    for(size_t i = 0; i < fzModel->int_vars.size(); i += 1) {
+       auto theVar = makeIntVar(cp, fzModel->int_vars[i]);
+       nbV += !theVar->isBound();
+       int_vars.push_back(theVar);
+    }
+    search_statistics.setIntVars(nbV);
+    nbV = 0;
+    for(size_t i = 0; i < fzModel->bool_vars.size(); i += 1) {
+       auto theVar = makeBoolVar(cp, fzModel->bool_vars[i]);
+       nbV += !theVar->isBound();
+       bool_vars.push_back(theVar);
+    }
+    search_statistics.setBoolVars(nbV);
+
+    //Create and post constraints
+    search_statistics.setPropagators(fzModel->constraints.size());
+    for(size_t i = 0; i < fzModel->constraints.size(); i += 1)
+    {
+        cp->post(Factory::makeConstraint(cp, fzModel->constraints[i], int_vars, bool_vars));
+    }
+}
+
+Objective::Ptr makeObjective(FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars)
+{
+    if (fzModel->method.type == FlatZinc::Method::Type::Minimization)
+    {
+        return Factory::minimize(int_vars[fzModel->objective_variable]);
+    }
+    else if(fzModel->method.type == FlatZinc::Method::Type::Maximization)
+    {
+        return Factory::maximize(int_vars[fzModel->objective_variable]);
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+// The parallel searches call the builder once per thread, so the FlatZinc model is shared read-only.
+// Worker 0 reports the size of the model in `model_statistics` (when given).
+ModelBuilder makeModelBuilder(FlatZinc::FlatZincModel* fzModel, bool portfolio, SearchStatistics* model_statistics)
+{
+    return [fzModel, portfolio, model_statistics](CPSolver::Ptr cp, int worker)
+    {
+        std::vector<var<int>::Ptr> int_vars;
+        std::vector<var<bool>::Ptr> bool_vars;
+        SearchStatistics unused;
+        makeModel(cp, fzModel, int_vars, bool_vars, worker == 0 and model_statistics ? *model_statistics : unused);
+        ParallelModel model;
+        if (portfolio)
+        {
+            model.branching = makePortfolioHeuristic(cp, fzModel, int_vars, bool_vars, worker);
+            if (worker >= 4)
+                model.restarts = Restart::luby(100);
+        }
+        else
+            model.branching = land(makeSearchCombinator(cp, fzModel->search_combinator, int_vars, bool_vars));
+        model.objective = makeObjective(fzModel, int_vars);
+        model.onSolution = [fzModel, int_vars, bool_vars]() mutable
+        {
+            fzModel->print(std::cout, int_vars, bool_vars);
+            std::cout << "----------\n";
+        };
+        return model;
+    };
+}
+
 // Variable selections
 template<typename Vars, typename Var>
-std::function<Var(Vars)> makeVariableSelection(FlatZinc::SearchHeuristic::VariableSelection& variable_selection)
+std::function<Var(Vars)> makeVariableSelection(CPSolver::Ptr cp, FlatZinc::SearchHeuristic::VariableSelection& variable_selection)
 {
     if (variable_selection == FlatZinc::SearchHeuristic::VariableSelection::first_fail)
     {
@@ -186,6 +315,20 @@ std::function<Var(Vars)> makeVariableSelection(FlatZinc::SearchHeuristic::Variab
     {
         return [](Vars vars) -> Var {return largest<Vars,Var>(vars);};
     }
+    else if (variable_selection == FlatZinc::SearchHeuristic::VariableSelection::dom_w_deg)
+    {
+        return [](Vars vars) -> Var {return dom_w_deg<Vars,Var>(vars);};
+    }
+    else if (variable_selection == FlatZinc::SearchHeuristic::VariableSelection::activity)
+    {
+        cp->setScoring(true);
+        return [cp](Vars vars) -> Var {return activity<Vars,Var>(vars, cp->scores());};
+    }
+    else if (variable_selection == FlatZinc::SearchHeuristic::VariableSelection::impact)
+    {
+        cp->setScoring(true);
+        return [cp](Vars vars) -> Var {return impact<Vars,Var>(vars, cp->scores());};
+    }
     else
     {
         printError("Unexpected variable selection");
@@ -225,8 +368,18 @@ std::function<Branches(void)> makeSearchHeuristic(CPSolver::Ptr cp, FlatZinc::Se
             decision_variables.push_back(int_vars[sh.decision_variables[i]]);
         }
 
-        auto varSel = makeVariableSelection<std::vector<var<int>::Ptr>, var<int>::Ptr>(sh.variable_selection);
         auto valSel = makeValueSelection<var<int>::Ptr, int>(sh.value_selection);
+        if (sh.variable_selection == FlatZinc::SearchHeuristic::VariableSelection::first_fail and decision_variables.size() >= 1000)
+        {
+            // Same choices as first_fail: with many variables, maintaining a heap beats scanning them at every node
+            VarHeap::Ptr heap = new (cp) VarHeap(cp, decision_variables);
+            cp->post(heap);
+            return [=]()
+            {
+                return valSel(cp, heap->top());
+            };
+        }
+        auto varSel = makeVariableSelection<std::vector<var<int>::Ptr>, var<int>::Ptr>(cp, sh.variable_selection);
         return [=]()
         {
             return valSel(cp, varSel(decision_variables));
@@ -240,7 +393,7 @@ std::function<Branches(void)> makeSearchHeuristic(CPSolver::Ptr cp, FlatZinc::Se
             decision_variables.push_back(bool_vars[sh.decision_variables[i]]);
         }
 
-        auto varSel = makeVariableSelection<std::vector<var<bool>::Ptr>, var<bool>::Ptr>(sh.variable_selection);
+        auto varSel = makeVariableSelection<std::vector<var<bool>::Ptr>, var<bool>::Ptr>(cp, sh.variable_selection);
         auto valSel = makeValueSelection<var<bool>::Ptr, int>(sh.value_selection);
         return [=]()
         {
@@ -254,21 +407,21 @@ std::function<Branches(void)> makeSearchHeuristic(CPSolver::Ptr cp, FlatZinc::Se
     }
 }
 
-std::vector<std::function<Branches(void)>> makeSearchCombinator(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel,  std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars)
+std::vector<std::function<Branches(void)>> makeSearchCombinator(CPSolver::Ptr cp, std::vector<FlatZinc::SearchHeuristic> search_combinator,  std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars)
 {
     // Initialize not decision variables as all the variables
    std::set<int> int_not_decision_vars;
    std::set<int> bool_not_decision_vars;
-   for (size_t i = 0; i < fzModel->int_vars.size(); i += 1)
+   for (size_t i = 0; i < int_vars.size(); i += 1)
       int_not_decision_vars.insert(int_not_decision_vars.end(), i);
-   for (size_t i = 0; i < fzModel->bool_vars.size(); i += 1)
+   for (size_t i = 0; i < bool_vars.size(); i += 1)
       bool_not_decision_vars.insert(bool_not_decision_vars.end(), i);
 
    //Create the search heuristics
     std::vector<std::function<Branches(void)>> search_heuristics;
-    for (size_t i = 0; i < fzModel->search_combinator.size(); i += 1)
+    for (size_t i = 0; i < search_combinator.size(); i += 1)
     {
-        auto& sh =  fzModel->search_combinator[i];
+        auto& sh =  search_combinator[i];
         search_heuristics.push_back(makeSearchHeuristic(cp, sh, int_vars, bool_vars));
         //std::cout << "SC[" << i << "] covers " << sh.decision_variables.size() << " variables\n";
         //Remove decision variables from not decision variables
@@ -310,6 +463,61 @@ std::vector<std::function<Branches(void)>> makeSearchCombinator(CPSolver::Ptr cp
     return search_heuristics;
 }
 
+template<typename Var>
+std::function<Branches(void)> makeRandomHeuristic(CPSolver::Ptr cp, std::vector<Var> const & vars, unsigned int seed)
+{
+    using namespace Factory;
+    auto rng = std::make_shared<std::mt19937>(seed);
+    return [cp, vars, rng]() -> Branches
+    {
+        // First fail with ties broken at random
+        Var x = selectMin(vars,
+                          [](Var const & y) { return y->size() > 1; },
+                          [](Var const & y) { return y->size(); },
+                          *rng);
+        if (not x)
+            return Branches({});
+
+        // Random value first
+        int val = x->min();
+        for (int k = (*rng)() % x->size(); not x->contains(val) or k-- > 0; val += 1);
+        return [cp, x, val] { return cp->post(x == val); }
+             | [cp, x, val] { return cp->post(x != val); };
+    };
+}
+
+// Portfolio (-p): worker 0 follows the search annotations of the model, workers 1 to 3 replace
+// their variable selection with first_fail, smallest and dom_w_deg, and the others branch at random
+// (each one with its own seed) and restart on the Luby schedule (see makeModelBuilder).
+std::function<Branches(void)> makePortfolioHeuristic(CPSolver::Ptr cp, FlatZinc::FlatZincModel* fzModel, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars, int worker)
+{
+    if (worker <= 3)
+    {
+        std::vector<FlatZinc::SearchHeuristic> search_combinator = fzModel->search_combinator;
+        for (auto& sh : search_combinator)
+        {
+            if (worker == 1)
+            {
+                sh.variable_selection = FlatZinc::SearchHeuristic::VariableSelection::first_fail;
+            }
+            else if (worker == 2)
+            {
+                sh.variable_selection = FlatZinc::SearchHeuristic::VariableSelection::smallest;
+                sh.value_selection = FlatZinc::SearchHeuristic::ValueSelection::indomain_min;
+            }
+            else if (worker == 3)
+            {
+                sh.variable_selection = FlatZinc::SearchHeuristic::VariableSelection::dom_w_deg;
+            }
+        }
+        return land(makeSearchCombinator(cp, search_combinator, int_vars, bool_vars));
+    }
+    else
+    {
+        return land({makeRandomHeuristic(cp, int_vars, worker), makeRandomHeuristic(cp, bool_vars, worker)});
+    }
+}
+
 Limit makeLimit(int solution_limit, int time_limit)
 {
     return [=](SearchStatistics const & search_statistics)
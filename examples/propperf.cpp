@@ -0,0 +1,91 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include <iostream>
+#include <iomanip>
+#include "solver.hpp"
+#include "trailable.hpp"
+#include "intvar.hpp"
+#include "constraint.hpp"
+#include "RuntimeMonitor.hpp"
+
+/*
+ * Measures the propagation throughput of the bound-consistent arithmetic (LessOrEqual, EQBinBC and Sum).
+ * A chain of x[i] <= x[i+1], of y[i] == x[i] + 1 and of sums over blocks of 8 is tightened from both
+ * ends then restored, round after round. The model is run twice: once on plain variables, which the
+ * propagators reach without virtual calls (see concrete), and once on offset views of those, which
+ * take the generic path.
+ * Usage: propperf [variables] [rounds]
+ */
+
+struct Run {
+   unsigned long long _props;
+   double             _ms;
+};
+
+Run chain(int n,int rounds,bool views)
+{
+   using namespace Factory;
+   const int range = 4 * n;
+   CPSolver::Ptr cp  = Factory::makeSolver();
+   const int o = views ? 1 : 0;   // x + 0 would be x itself
+   auto x = Factory::intVarArray(cp,n,-o,range - o);
+   auto y = Factory::intVarArray(cp,n,1 - o,range + 1 - o);
+   std::vector<var<int>::Ptr> vx(n),vy(n);
+   for(int i=0;i < n;i++) {
+      vx[i] = views ? x[i] + o : x[i];
+      vy[i] = views ? y[i] + o : y[i];
+   }
+   for(int i=0;i < n - 1;i++)
+      cp->post(vx[i] <= vx[i+1]);
+   for(int i=0;i < n;i++)
+      cp->post(equal(vy[i],vx[i],1));
+   for(int i=0;i + 8 <= n;i += 8) {
+      std::vector<var<int>::Ptr> block(vx.begin() + i,vx.begin() + i + 8);
+      cp->post(sum(block,Factory::makeIntVar(cp,0,8 * range)));
+   }
+   cp->getStateManager()->enable();   // as a search does, so that restoreState undoes the round
+   const auto props = cp->getPropagations();
+   auto start = RuntimeMonitor::now();
+   for(int r=0;r < rounds;r++) {
+      cp->getStateManager()->saveState();
+      TRYFAIL
+         vx[0]->removeBelow(r % n);
+         vy[n-1]->removeAbove(range + 1 - r % n);
+         cp->fixpoint();
+      ONFAIL
+      ENDFAIL
+      cp->getStateManager()->restoreState();
+   }
+   Run run { cp->getPropagations() - props,RuntimeMonitor::elapsedSince(start) };
+   cp.dealloc();
+   return run;
+}
+
+int main(int argc,char* argv[])
+{
+   using namespace std;
+   const int n      = argc >= 2 ? atoi(argv[1]) : 256;
+   const int rounds = argc >= 3 ? atoi(argv[2]) : 5000;
+   double rate[2];
+   for(int views = 0;views <= 1;views++) {
+      Run run = chain(n,rounds,views == 1);
+      rate[views] = run._props / max(run._ms,1.0) * 1000.0;
+      cout << setw(10) << (views ? "views" : "plain") << setw(10) << (long)run._ms << " ms  "
+           << run._props << " propagations  " << (long)rate[views] << " propagations/s" << endl;
+   }
+   cout << setw(10) << "speedup" << "  " << setprecision(3) << rate[0] / max(rate[1],1.0) << endl;
+   return 0;
+}
@@ -16,12 +16,12 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
-#include <random>
 #include "solver.hpp"
 #include "trailable.hpp"
 #include "intvar.hpp"
 #include "constraint.hpp"
 #include "search.hpp"
+#include "lns.hpp"
 
 int main(int argc,char* argv[])
 {
@@ -49,35 +49,18 @@ int main(int argc,char* argv[])
           wDist[k++] = w[i][j] * Factory::element(d,x[i],x[j]);
     Objective::Ptr obj = Factory::minimize(Factory::sum(wDist));
 
-    DFSearch search(cp,firstFail(cp,x));
-    std::vector<int> best(n);    
+    LNS lns(cp,x,obj,firstFail(cp,x));
+    lns.add(std::make_shared<RandomNeighborhood>());
+    lns.add(std::make_shared<PropagationGuidedNeighborhood>());
+    lns.add(std::make_shared<CostImpactNeighborhood>());
+    lns.setFailureLimit(100);
+    lns.reportEvery(1.0);
+    lns.onSolution([&obj]() { cout << "objective = " << obj->value() << endl;});
 
-    
-    search.onSolution([&x,&obj,&best,n]() {
-                         for(int i=0;i<n;i++)
-                            best[i] = x[i]->min();
-                         cout << "objective = " << obj->value() << endl;
-                      });
-
-    int nRestarts = 1000;
-    int failureLimit = 100;
-    std::random_device rand;  
-    std::mt19937 gen(rand()); 
-    std::uniform_int_distribution<> dist(0, 100);
-
-    for(int i=0;i<nRestarts;i++) {
-       if (i%10==0)
-          std::cout << "restart number #" << i << std::endl;
-       search.optimizeSubjectTo(obj,
-                                [&failureLimit](const SearchStatistics& stats) {
-                                   return stats.numberOfFailures() >= failureLimit;
-                                },
-                                [n,cp,&x,best,&dist,&gen] {
-                                   for(int j=0;j < n;j++)
-                                      if (dist(gen) < 5)
-                                         cp->post(x[j] == best[j]);
-                                });
-    }
+    auto stats = lns.optimize([](const SearchStatistics& stats) {
+                                 return RuntimeMonitor::elapsedSeconds(stats.startTime()) >= 10;
+                              });
+    cout << stats << endl;
     cp.dealloc();
     return 0;
 }
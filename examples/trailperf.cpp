@@ -0,0 +1,228 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <stack>
+#include <tuple>
+#include <vector>
+#include <cassert>
+#include "solver.hpp"
+#include "trailable.hpp"
+#include "intvar.hpp"
+#include "constraint.hpp"
+#include "search.hpp"
+#include "RuntimeMonitor.hpp"
+
+/*
+ * Benchmarks the trail. The same depth-first walk (every node writes random trailed integers,
+ * then backtracks) runs once on a copy of the previous trail (a stack of virtual entries
+ * allocated on a block) and once on the Trailer with its value records. The nqperf (all the
+ * solutions) and msperf models are then solved on the Trailer to report its statistics.
+ * Usage: trailperf [walk depth] [queens size] [magic square solutions]
+ */
+
+namespace baseline {   // the trail as it was before value records
+   class Entry {
+   public:
+      virtual void restore() noexcept = 0;
+   };
+   class Trailer {
+      std::stack<Entry*>                           _trail;
+      std::stack<std::tuple<std::size_t,std::size_t>> _tops;
+      int         _magic;
+      char*       _block;
+      std::size_t _bsz;
+      std::size_t _btop;
+   public:
+      Trailer(std::size_t sz = 1 << 28) : _magic(-1),_block((char*)malloc(sz)),_bsz(sz),_btop(0) {}
+      ~Trailer() { free(_block);}
+      int magic() const noexcept { return _magic;}
+      void* allocate(std::size_t sz) {
+         assert(_btop + sz <= _bsz);   // the previous trail grew by relocating its entries
+         char* ptr = _block + _btop;
+         _btop += sz;
+         return ptr;
+      }
+      void trail(Entry* e) { _trail.push(e);}
+      void push() {
+         ++_magic;
+         _tops.emplace(std::make_tuple(_trail.size(),_btop));
+      }
+      void pop() {
+         std::size_t to,mem;
+         std::tie(to,mem) = _tops.top();
+         _tops.pop();
+         while (_trail.size() != to) {
+            Entry* entry = _trail.top();
+            entry->restore();
+            _trail.pop();
+         }
+         _btop = mem;
+      }
+   };
+   template <class T> class trail {
+      Trailer* _ctx;
+      int      _magic;
+      T        _value;
+      class TrailEntry : public Entry {
+         T* _at;
+         T  _old;
+      public:
+         TrailEntry(T* at) : _at(at),_old(*at) {}
+         void restore() noexcept override { *_at = _old;}
+      };
+   public:
+      trail(Trailer* ctx,const T& v = T()) : _ctx(ctx),_magic(ctx->magic()),_value(v) {}
+      operator T() const noexcept { return _value;}
+      trail<T>& operator=(const T& v) {
+         int cm = _ctx->magic();
+         if (_magic != cm) {
+            _magic = cm;
+            _ctx->trail(new (_ctx->allocate(sizeof(TrailEntry))) TrailEntry(&_value));
+         }
+         _value = v;
+         return *this;
+      }
+   };
+};
+
+/*
+ * A binary tree of the given depth. Each node writes `writes` random cells of `x`. Returns the
+ * sum of a random cell read at each leaf (identical for both trails).
+ */
+template <class Push,class Pop,class X>
+long long walk(const Push& push,const Pop& pop,X& x,std::mt19937& rng,int depth,int writes)
+{
+   if (depth == 0)
+      return x[rng() % x.size()];
+   long long sum = 0;
+   for(int b = 0;b < 2;b++) {
+      push();
+      for(int k = 0;k < writes;k++) {
+         auto& c = x[rng() % x.size()];
+         c = c + 1;
+      }
+      sum += walk(push,pop,x,rng,depth - 1,writes);
+      pop();
+   }
+   return sum;
+}
+
+void benchWalk(int depth)
+{
+   using namespace std;
+   const int n = 1024,writes = 64;
+   long long sum[2];
+   double t[2];
+   {
+      baseline::Trailer bt;
+      vector<baseline::trail<int>> x(n,baseline::trail<int>(&bt,0));
+      mt19937 rng(42);
+      auto start = RuntimeMonitor::now();
+      sum[0] = walk([&bt] { bt.push();},[&bt] { bt.pop();},x,rng,depth,writes);
+      t[0] = RuntimeMonitor::elapsedSince(start);
+   }
+   {
+      Trailer::Ptr tr = new Trailer;
+      tr->enable();
+      vector<trail<int>> x(n,trail<int>(tr,0));
+      mt19937 rng(42);
+      auto start = RuntimeMonitor::now();
+      sum[1] = walk([&tr] { tr->push();},[&tr] { tr->pop();},x,rng,depth,writes);
+      t[1] = RuntimeMonitor::elapsedSince(start);
+      cout << tr->stats();
+      tr.dealloc();
+   }
+   cout << setw(10) << "walk" << "  baseline" << setw(10) << (long)t[0] << " ms" << endl;
+   cout << setw(10) << "walk" << "  values  " << setw(10) << (long)t[1] << " ms"
+        << (sum[0] == sum[1] ? "" : "  MISMATCH") << endl;
+   cout << setw(10) << "walk" << "  speedup   " << setprecision(3) << t[0] / max(t[1],1.0) << endl;
+}
+
+SearchStatistics queens(int n)
+{
+   using namespace Factory;
+   CPSolver::Ptr cp  = Factory::makeSolver();
+   auto q = Factory::intVarArray(cp,n,1,n);
+   for(int i=0;i < n;i++)
+      for(int j=i+1;j < n;j++) {
+         cp->post(q[i] != q[j]);
+         cp->post(Factory::notEqual(q[i],q[j],i-j));
+         cp->post(Factory::notEqual(q[i],q[j],j-i));
+      }
+   DFSearch search(cp,[=]() {
+                         auto x = selectMin(q,
+                                            [](const auto& x) { return x->size() > 1;},
+                                            [](const auto& x) { return x->size();});
+                         if (x) {
+                            int c = x->min();
+                            return  [=] { cp->post(x == c);}
+                               | [=] { cp->post(x != c);};
+                         } else return Branches({});
+                      });
+   auto stat = search.solve();
+   std::cout << cp->getStateManager()->stats();
+   cp.dealloc();
+   return stat;
+}
+
+SearchStatistics magicSquare(int nbSol)
+{
+   using namespace Factory;
+   const int n = 5;
+   const int sumResult = n * (n * n + 1) / 2;
+   CPSolver::Ptr cp  = Factory::makeSolver();
+   Matrix<var<int>::Ptr,2> x({n,n});
+   for(int i=0;i < n;i++)
+      for(int j=0;j < n;j++)
+         x[i][j] = Factory::makeIntVar(cp,1,n*n);
+   cp->post(Factory::allDifferent(x.flat()));
+   for(int i=0;i<n;i++)
+      cp->post(sum(slice<var<int>::Ptr>(0,n,[i,&x](int j) { return x[i][j];}),sumResult));
+   for(int j=0;j<n;j++)
+      cp->post(sum(slice<var<int>::Ptr>(0,n,[j,&x](int i) { return x[i][j];}),sumResult));
+   cp->post(sum(slice<var<int>::Ptr>(0,n,[&x](int i) { return x[i][i];}),sumResult));
+   cp->post(sum(slice<var<int>::Ptr>(0,n,[&x](int i) { return x[n-i-1][i];}),sumResult));
+   cp->post(x[0][n-1] <= x[n-1][0] - 1);
+   cp->post(x[0][0] <= x[n-1][n-1] - 1);
+   cp->post(x[0][0] <= x[n-1][0] - 1);
+   DFSearch search(cp,firstFail(cp,x.flat()));
+   auto stat = search.solve([nbSol](const SearchStatistics& stats) { return stats.numberOfSolutions() >= nbSol;});
+   std::cout << cp->getStateManager()->stats();
+   cp.dealloc();
+   return stat;
+}
+
+template <class B> void bench(const char* name,const B& body)
+{
+   using namespace std;
+   auto start = RuntimeMonitor::now();
+   auto stat = body();
+   cout << setw(10) << name << "  values  " << setw(10) << (long)RuntimeMonitor::elapsedSince(start) << " ms  "
+        << stat.numberOfNodes() << " nodes  " << stat.numberOfFailures() << " failures" << endl;
+}
+
+int main(int argc,char* argv[])
+{
+   const int depth = argc >= 2 ? atoi(argv[1]) : 18;
+   const int n     = argc >= 3 ? atoi(argv[2]) : 12;
+   const int nbSol = argc >= 4 ? atoi(argv[3]) : 1000;
+   benchWalk(depth);
+   bench("nqperf",[n]() { return queens(n);});
+   bench("msperf",[nbSol]() { return magicSquare(nbSol);});
+   return 0;
+}
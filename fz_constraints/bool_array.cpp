@@ -1,11 +1,13 @@
 #include <limits>
 #include <fz_constraints/bool_array.hpp>
+#include <lcg.hpp>
 
 
 array_bool::array_bool(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     Constraint(cp),
     _as()
 {
+    setPriority(LINEAR);
     for(size_t i = 0; i < fzConstraint.vars.size(); i += 1)
     {
         _as.push_back(bool_vars[fzConstraint.vars[i]]);
@@ -20,6 +22,18 @@ void array_bool::post()
     }
 }
 
+// The propagators only reason on the fixed variables
+bool array_bool::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::allBounds(_as, reason);
+    return true;
+}
+
+bool array_bool::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
+}
+
 array_bool_reif::array_bool_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     array_bool(cp, fzConstraint, int_vars, bool_vars)
 {
@@ -33,6 +47,11 @@ void array_bool_reif::post()
     _r->propagateOnBind(this);
 }
 
+bool array_bool_reif::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::bounds(_r, reason);
+    return array_bool::explain(l, reason);
+}
 
 array_bool_and_imp::array_bool_and_imp(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
         array_bool_reif(cp, fzConstraint, int_vars, bool_vars)
@@ -73,10 +92,7 @@ void array_bool_and_imp::propagate()
                 x->assign(true);
             }
         }
-        else
-        {
-            setActive(false);
-        }
+        setActive(false);
     }
 }
 
@@ -131,10 +147,12 @@ void array_bool_and_reif::propagate()
             {
                 x->assign(true);
             }
+            setActive(false);
         }
         else if (asSatisfied and notBoundCount == 1)
         {
             asNotBound->assign(false);
+            setActive(false);
         }
     }
 }
@@ -145,6 +163,7 @@ array_bool_element::array_bool_element(CPSolver::Ptr cp, FlatZinc::Constraint& f
     _as(),
     _c(bool_vars[fzConstraint.vars[1]])
 {
+    setPriority(LINEAR);
     _as.push_back(0); // Index from 1
     for(size_t i = 0; i < fzConstraint.consts.size(); i += 1)
     {
@@ -187,9 +206,25 @@ void array_bool_element::propagate()
             _b->remove(bVal);
         }
     }
+
+    if (_b->isBound())
+    {
+        setActive(false);
+    }
 }
 
+// The index is filtered on its domain
+bool array_bool_element::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::domain(_b, reason);
+    LCG::bounds(_c, reason);
+    return true;
+}
 
+bool array_bool_element::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
+}
 
 array_bool_or_imp::array_bool_or_imp(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
         array_bool_reif(cp, fzConstraint, int_vars, bool_vars)
@@ -227,16 +262,22 @@ void array_bool_or_imp::propagate()
         _r->assign(false);
     }
 
+    //Entailment: as1 \/ ... \/ asn holds whatever r
+    if (asSatisfied)
+    {
+        setActive(false);
+    }
     //Propagation: r -> as1 \/ ... \/ asn
-    if (_r->isBound())
+    else if (_r->isBound())
     {
         if(_r->isFalse())
         {
             setActive(false);
         }
-        else if ((not asSatisfied) and notBoundCount == 1)
+        else if (notBoundCount == 1)
         {
             asNotBound->assign(true);
+            setActive(false);
         }
     }
 }
@@ -292,10 +333,12 @@ void array_bool_or_reif::propagate()
             {
                 x->assign(false);
             }
+            setActive(false);
         }
         else if (not asSatisfied and notBoundCount == 1)
         {
             asNotBound->assign(true);
+            setActive(false);
         }
     }
 }
@@ -342,6 +385,7 @@ array_var_bool_element::array_var_bool_element(CPSolver::Ptr cp, FlatZinc::Const
     _as(),
     _c(bool_vars[fzConstraint.vars.back()])
 {
+    setPriority(LINEAR);
     _as.push_back(nullptr); // Index from 1
     for(size_t i = 1; i < fzConstraint.vars.size() - 1; i += 1)
     {
@@ -395,4 +439,21 @@ void array_var_bool_element::propagate()
             }
         }
     }
+}
+
+// The index is filtered on its domain
+bool array_var_bool_element::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::domain(_b, reason);
+    for(size_t i = 1; i < _as.size(); i += 1) // Index from 1
+    {
+        LCG::bounds(_as[i], reason);
+    }
+    LCG::bounds(_c, reason);
+    return true;
+}
+
+bool array_var_bool_element::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
 }
\ No newline at end of file
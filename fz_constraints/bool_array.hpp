@@ -11,6 +11,8 @@ class array_bool : public Constraint
     public:
         array_bool(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
 
 class array_bool_reif : public array_bool
@@ -21,6 +23,7 @@ class array_bool_reif : public array_bool
     public:
         array_bool_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
 };
 
 class array_bool_and_imp : public array_bool_reif
@@ -50,6 +53,8 @@ class array_bool_element : public Constraint
         array_bool_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
 
 class array_bool_or_imp : public array_bool_reif
@@ -87,4 +92,6 @@ class array_var_bool_element : public Constraint
         array_var_bool_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
\ No newline at end of file
@@ -4,7 +4,9 @@ bool_bin::bool_bin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::ve
     Constraint(cp),
     _a(bool_vars[fzConstraint.vars[0]]),
     _b(bool_vars[fzConstraint.vars[1]])
-{}
+{
+    setPriority(BINARY);
+}
 
 void bool_bin::post()
 {
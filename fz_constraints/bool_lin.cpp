@@ -9,6 +9,7 @@ bool_lin::bool_lin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::ve
     _bs_neg(),
     _c(fzConstraint.consts.back())
 {
+    setPriority(LINEAR);
     for(size_t i = 0; i < fzConstraint.consts.size() - 1; i += 1)
     {
         if(fzConstraint.consts[i] > 0)
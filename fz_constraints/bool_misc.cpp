@@ -1,10 +1,13 @@
 #include <fz_constraints/bool_misc.hpp>
+#include <lcg.hpp>
 
 bool2int::bool2int(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     Constraint(cp),
     _a(bool_vars[fzConstraint.vars[0]]),
     _b(int_vars[fzConstraint.vars[1]])
-{}
+{
+    setPriority(BINARY);
+}
 
 void bool2int::post()
 {
@@ -32,10 +35,23 @@ void bool2int::propagate()
     }
 }
 
+bool bool2int::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::bounds(_a, reason);
+    LCG::bounds(_b, reason);
+    return true;
+}
+
+bool bool2int::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
+}
+
 bool_clause::bool_clause(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars):
     Constraint(cp),
     _as(),
-    _bs()
+    _bs(),
+    _clause(nullptr)
 {
     for(int i = 0; i < fzConstraint.consts[0]; i += 1)
     {
@@ -45,74 +61,22 @@ bool_clause::bool_clause(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, s
     {
         _bs.push_back(bool_vars[fzConstraint.vars[i]]);
     }
-}
-
-void bool_clause::post()
-{
-    for(auto x : _as)
+    if(not (_as.empty() and _bs.empty()))
     {
-        x->propagateOnBind(this);
-    }
-    for(auto x : _bs)
-    {
-        x->propagateOnBind(this);
+        _clause = new (cp) Clause(_as, _bs);
     }
 }
 
-void bool_clause::propagate()
+void bool_clause::post()
 {
     //Semantic: (as1 \/ ... \/ asn) \/ (-bs1 \/ ... \/ -bsm)
-    bool asSatisfied = false;
-    bool bsSatisfied = false;
-    int asNotBoundCount = 0;
-    int bsNotBoundCount = 0;
-    var<bool>::Ptr asNotBound = nullptr;
-    var<bool>::Ptr bsNotBound = nullptr;
-    for(auto x : _as)
+    if(_clause.get() == nullptr)
     {
-        if(not x->isBound())
-        {
-            asNotBoundCount += 1;
-            asNotBound = x;
-        }
-        else if (x->isTrue())
-        {
-            asSatisfied = true;
-            break;
-        }
-    }
-    for(auto x : _bs)
-    {
-        if(not x->isBound())
-        {
-            bsNotBoundCount += 1;
-            bsNotBound = x;
-        }
-        else if (x->isFalse())
-        {
-            bsSatisfied = true;
-            break;
-        }
+        failNow();
     }
 
-    //Propagation: (as1 \/ ... \/ asn) \/ (-bs1 \/ ... \/ -bsm)
-    if(asSatisfied or bsSatisfied)
-    {
-        setActive(false);
-    }
-    else
-    {
-        if (asNotBoundCount == 0 and bsNotBoundCount == 0)
-        {
-            failNow();
-        }
-        else if (asNotBoundCount == 1 and bsNotBoundCount == 0)
-        {
-            asNotBound->assign(true);
-        }
-        else if (asNotBoundCount == 0 and bsNotBoundCount == 1)
-        {
-            bsNotBound->assign(false);
-        }
-    }
-}
\ No newline at end of file
+    //Propagation: watched literals (see Clause), the clause only wakes up when a watched literal is bound
+    setActive(false);
+    auto cp = _as.empty() ? _bs[0]->getSolver() : _as[0]->getSolver();
+    cp->post(_clause, false);
+}
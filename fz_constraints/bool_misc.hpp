@@ -1,6 +1,7 @@
 #pragma once
 
 #include <intvar.hpp>
+#include <constraint.hpp>
 #include <fz_parser/flatzinc.h>
 
 class bool2int : public Constraint
@@ -13,6 +14,8 @@ class bool2int : public Constraint
         bool2int(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
 
 class bool_clause : public Constraint
@@ -20,9 +23,9 @@ class bool_clause : public Constraint
     protected:
         std::vector<var<bool>::Ptr> _as;
         std::vector<var<bool>::Ptr> _bs;
+        Clause::Ptr _clause;
 
     public:
         bool_clause(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
-        void propagate() override;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <limits>
 #include <fz_constraints/int_array.hpp>
+#include <lcg.hpp>
 
 
 array_int_element::array_int_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
@@ -9,6 +10,7 @@ array_int_element::array_int_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzC
     _as(),
     _c(int_vars[fzConstraint.vars[1]])
 {
+    setPriority(LINEAR);
     _as.push_back(0); // Index from 1
     for(size_t i = 0; i < fzConstraint.consts.size(); i += 1)
     {
@@ -51,6 +53,24 @@ void array_int_element::propagate()
             _b->remove(bVal);
         }
     }
+
+    if (_b->isBound())
+    {
+        setActive(false);
+    }
+}
+
+// The index and the value are filtered on their domains
+bool array_int_element::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::domain(_b, reason);
+    LCG::domain(_c, reason);
+    return true;
+}
+
+bool array_int_element::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
 }
 
 array_int_maximum::array_int_maximum(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
@@ -58,6 +78,7 @@ array_int_maximum::array_int_maximum(CPSolver::Ptr cp, FlatZinc::Constraint& fzC
     _m(int_vars[fzConstraint.vars[0]]),
     _x()
 {
+    setPriority(LINEAR);
     for(size_t i = 1; i < fzConstraint.vars.size(); i += 1)
     {
         _x.push_back(int_vars[fzConstraint.vars[i]]);
@@ -101,6 +122,7 @@ array_int_minimum::array_int_minimum(CPSolver::Ptr cp, FlatZinc::Constraint& fzC
     _m(int_vars[fzConstraint.vars[0]]),
     _x()
 {
+    setPriority(LINEAR);
     for(size_t i = 1; i < fzConstraint.vars.size(); i += 1)
     {
         _x.push_back(int_vars[fzConstraint.vars[i]]);
@@ -145,6 +167,7 @@ array_var_int_element::array_var_int_element(CPSolver::Ptr cp, FlatZinc::Constra
     _as(),
     _c(int_vars[fzConstraint.vars.back()])
 {
+    setPriority(LINEAR);
     _as.push_back(nullptr); // Index from 1
     for(size_t i = 1; i < fzConstraint.vars.size() - 1; i += 1)
     {
@@ -204,4 +227,21 @@ void array_var_int_element::propagate()
             }
         }
     }
+}
+
+// The index is filtered on its domain, the array and the value on their bounds
+bool array_var_int_element::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::domain(_b, reason);
+    for(size_t i = 1; i < _as.size(); i += 1) // Index from 1
+    {
+        LCG::bounds(_as[i], reason);
+    }
+    LCG::bounds(_c, reason);
+    return true;
+}
+
+bool array_var_int_element::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
 }
\ No newline at end of file
@@ -14,6 +14,8 @@ class array_int_element : public Constraint
         array_int_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
 
 class array_int_maximum : public Constraint
@@ -51,4 +53,6 @@ class array_var_int_element : public Constraint
         array_var_int_element(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include <algorithm>
 #include <fz_constraints/int_bin.hpp>
+#include <lcg.hpp>
 
 int_bin::int_bin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     Constraint(cp),
     _a(int_vars[fzConstraint.vars[0]]),
     _b(int_vars[fzConstraint.vars[1]])
-{}
+{
+    setPriority(BINARY);
+}
 
 void int_bin::post()
 {
@@ -13,6 +16,19 @@ void int_bin::post()
     _b->propagateOnBoundChange(this);
 }
 
+// The propagators only reason on the bounds of the variables
+bool int_bin::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::bounds(_a, reason);
+    LCG::bounds(_b, reason);
+    return true;
+}
+
+bool int_bin::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
+}
+
 int_bin_reif::int_bin_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     int_bin(cp, fzConstraint, int_vars, bool_vars),
     _r(bool_vars[fzConstraint.vars[2]])
@@ -24,6 +40,12 @@ void int_bin_reif::post()
    _r->propagateOnBind(this);
 }
 
+bool int_bin_reif::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::bounds(_r, reason);
+    return int_bin::explain(l, reason);
+}
+
 int_abs::int_abs(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     int_bin(cp, fzConstraint, int_vars, bool_vars)
 {}
@@ -78,6 +100,11 @@ void int_abs::propagate()
         aMax = std::min(aMax, bMax);
     }
     _a->updateBounds(aMin,aMax);
+
+    if(_a->isBound() and _b->isBound())
+    {
+        setActive(false);
+    }
 }
 
 int_eq::int_eq(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
@@ -92,7 +119,12 @@ void int_eq::post()
 
 void int_eq::propagate()
 {
-   propagate(this, _a, _b);
+    propagate(this, _a, _b);
+
+    if(_a->isBound() and _b->isBound())
+    {
+        setActive(false);
+    }
 }
 
 void int_eq::propagate(Constraint* c, var<int>::Ptr _a, var<int>::Ptr _b)
@@ -137,12 +169,21 @@ void int_eq_imp::propagate()
         _r->assign(false);
     }
 
+    //Entailment: a = b holds whatever r
+    if(aMin == aMax and bMin == bMax and aMin == bMin)
+    {
+        setActive(false);
+    }
     //Propagation: r -> a = b
-    if (_r->isBound())
+    else if (_r->isBound())
     {
         if (_r->isTrue())
         {
             int_eq::propagate(this, _a, _b);
+            if(_a->isBound() and _b->isBound())
+            {
+                setActive(false);
+            }
         }
         else
         {
@@ -200,6 +241,10 @@ void int_eq_reif::propagate()
        if (_r->isTrue())
        {
            int_eq::propagate(this, _a, _b);
+           if(_a->isBound() and _b->isBound())
+           {
+               setActive(false);
+           }
        }
        else
        {
@@ -264,12 +309,21 @@ void int_le_imp::propagate()
         _r->assign(false);
     }
 
+    //Entailment: a <= b holds whatever r
+    if (_a->max() <= _b->min())
+    {
+        setActive(false);
+    }
     //Propagation: r -> a <= b
-    if (_r->isBound())
+    else if (_r->isBound())
     {
         if (_r->isTrue())
         {
             int_le::propagate(this, _a, _b);
+            if(_a->max() <= _b->min())
+            {
+                setActive(false);
+            }
         }
         else
         {
@@ -314,10 +368,18 @@ void int_le_reif::propagate()
         if (_r->isTrue())
         {
             int_le::propagate(this, _a, _b);
+            if(_a->max() <= _b->min())
+            {
+                setActive(false);
+            }
         }
         else
         {
             int_lt::propagate(this, _b, _a);
+            if(_b->max() < _a->min())
+            {
+                setActive(false);
+            }
         }
     }
 }
@@ -389,10 +451,18 @@ void int_lt_reif::propagate()
         if (_r->isTrue())
         {
             int_lt::propagate(this, _a, _b);
+            if(_a->max() < _b->min())
+            {
+                setActive(false);
+            }
         }
         else
         {
             int_le::propagate(this, _b, _a);
+            if(_b->max() <= _a->min())
+            {
+                setActive(false);
+            }
         }
     }
 }
@@ -499,5 +569,9 @@ void int_ne_reif::propagate()
         {
             int_eq::propagate(this, _a, _b);
         }
+        if(_a->isBound() and _b->isBound())
+        {
+            setActive(false);
+        }
     }
 }
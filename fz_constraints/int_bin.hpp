@@ -12,6 +12,8 @@ class int_bin : public Constraint
     public:
         int_bin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 };
 
 class int_bin_reif : public int_bin
@@ -22,6 +24,7 @@ class int_bin_reif : public int_bin
     public:
         int_bin_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
 };
 
 class int_abs : public int_bin
@@ -115,4 +118,5 @@ class int_ne_reif : public int_bin_reif
         int_ne_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
         void propagate() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override { return false; } // looks at the holes
 };
@@ -1,5 +1,6 @@
 #include <utils.hpp>
 #include <fz_constraints/int_lin.hpp>
+#include <lcg.hpp>
 
 int_lin::int_lin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     Constraint(cp),
@@ -9,6 +10,7 @@ int_lin::int_lin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vect
     _bs_neg(),
     _c(fzConstraint.consts.back())
 {
+    setPriority(LINEAR);
     for(size_t i = 0; i < fzConstraint.consts.size() - 1; i += 1)
     {
         if(fzConstraint.consts[i] > 0)
@@ -22,14 +24,32 @@ int_lin::int_lin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vect
             _bs_neg.push_back(int_vars[fzConstraint.vars[i]]);
         }
     }
+    _concrete = true;
+    for(auto x : _bs_pos)
+    {
+        _cs_pos.push_back(concrete(x));
+        _concrete = _concrete and _cs_pos.back() != nullptr;
+    }
+    for(auto x : _bs_neg)
+    {
+        _cs_neg.push_back(concrete(x));
+        _concrete = _concrete and _cs_neg.back() != nullptr;
+    }
 }
 
 void int_lin::calSumMinMax(int_lin* il)
+{
+    if (il->_concrete)
+        calSumMinMax(il, il->_cs_pos, il->_cs_neg);
+    else
+        calSumMinMax(il, il->_bs_pos, il->_bs_neg);
+}
+
+template <class Vec>
+void int_lin::calSumMinMax(int_lin* il, const Vec& _bs_pos, const Vec& _bs_neg)
 {
     auto& _as_pos = il->_as_pos;
     auto& _as_neg = il->_as_neg;
-    auto& _bs_pos = il->_bs_pos;
-    auto& _bs_neg = il->_bs_neg;
     auto& _sumMin = il->_sumMin;
     auto& _sumMax = il->_sumMax;
     auto& _posNotBoundCount = il->_posNotBoundCount;
@@ -90,6 +110,19 @@ void int_lin::post()
     }
 }
 
+// The propagators only reason on the bounds of the variables
+bool int_lin::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::allBounds(_bs_pos, reason);
+    LCG::allBounds(_bs_neg, reason);
+    return true;
+}
+
+bool int_lin::explainFailure(std::vector<Literal>& reason)
+{
+    return explain(Literal(), reason);
+}
+
 int_lin_reif::int_lin_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     int_lin(cp, fzConstraint, int_vars, bool_vars),
     _r(bool_vars[fzConstraint.vars.back()])
@@ -101,6 +134,12 @@ void int_lin_reif::post()
     _r->propagateOnBind(this);
 }
 
+bool int_lin_reif::explain(const Literal& l, std::vector<Literal>& reason)
+{
+    LCG::bounds(_r, reason);
+    return int_lin::explain(l, reason);
+}
+
 int_lin_eq::int_lin_eq(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars) :
     int_lin(cp, fzConstraint, int_vars, bool_vars)
 {}
@@ -163,6 +202,10 @@ void int_lin_eq_imp::propagate()
         if(_r->isTrue())
         {
             int_lin_eq::propagate(this);
+            if(_sumMin == _sumMax and _sumMin == _c)
+            {
+                setActive(false);
+            }
         }
         else
         {
@@ -204,6 +247,10 @@ void int_lin_eq_reif::propagate()
         if(_r->isTrue())
         {
             int_lin_eq::propagate(this);
+            if(_sumMin == _sumMax and _sumMin == _c)
+            {
+                setActive(false);
+            }
         }
         else
         {
@@ -213,12 +260,19 @@ void int_lin_eq_reif::propagate()
 }
 
 void int_lin_ge::propagate(int_lin* il, int c)
+{
+    if (il->_concrete)
+        propagate(il, c, il->_cs_pos, il->_cs_neg);
+    else
+        propagate(il, c, il->_bs_pos, il->_bs_neg);
+}
+
+template <class Vec>
+void int_lin_ge::propagate(int_lin* il, int c, const Vec& _bs_pos, const Vec& _bs_neg)
 {
     //Semantic: as1*bs1 + ... + asn*bsn >= c
     auto& _as_pos = il->_as_pos;
     auto& _as_neg = il->_as_neg;
-    auto& _bs_pos = il->_bs_pos;
-    auto& _bs_neg = il->_bs_neg;
     auto& _c = c;
     auto& _sumMin = il->_sumMin;
     auto& _sumMax = il->_sumMax;
@@ -275,12 +329,19 @@ void int_lin_le::propagate()
 }
 
 void int_lin_le::propagate(int_lin* il)
+{
+    if (il->_concrete)
+        propagate(il, il->_cs_pos, il->_cs_neg);
+    else
+        propagate(il, il->_bs_pos, il->_bs_neg);
+}
+
+template <class Vec>
+void int_lin_le::propagate(int_lin* il, const Vec& _bs_pos, const Vec& _bs_neg)
 {
     //Semantic: as1*bs1 + ... + asn*bsn <= c
     auto& _as_pos = il->_as_pos;
     auto& _as_neg = il->_as_neg;
-    auto& _bs_pos = il->_bs_pos;
-    auto& _bs_neg = il->_bs_neg;
     auto& _c = il->_c;
     auto& _sumMin = il->_sumMin;
     auto& _sumMax = il->_sumMax;
@@ -332,12 +393,21 @@ void int_lin_le_imp::propagate()
         _r->assign(false);
     }
 
+    //Entailment: as1*bs1 + ... + asn*bsn <= c holds whatever r
+    if(_sumMax <= _c)
+    {
+        setActive(false);
+    }
     //Propagation: r -> as1*bs1 + ... + asn*bsn <= c
-    if (_r->isBound())
+    else if (_r->isBound())
     {
         if (_r->isTrue())
         {
             int_lin_le::propagate(this);
+            if(_sumMax <= _c)
+            {
+                setActive(false);
+            }
         }
         else
         {
@@ -380,10 +450,18 @@ void int_lin_le_reif::propagate()
         if (_r->isTrue())
         {
             int_lin_le::propagate(this);
+            if(_sumMax <= _c)
+            {
+                setActive(false);
+            }
         }
         else
         {
             int_lin_ge::propagate(this, _c + 1);
+            if(_c < _sumMin)
+            {
+                setActive(false);
+            }
         }
     }
 }
@@ -470,8 +548,13 @@ void int_lin_ne_imp::propagate()
         _r->assign(false);
     }
 
+    //Entailment: as1*bs1 + ... + asn*bsn != c holds whatever r
+    if(_c < _sumMin or _sumMax < _c)
+    {
+        setActive(false);
+    }
     //Propagation: r -> as1*bs1 + ... + asn*bsn != c
-    if (_r->isBound())
+    else if (_r->isBound())
     {
         if(_r->isTrue())
         {
@@ -521,6 +604,10 @@ void int_lin_ne_reif::propagate()
         else
         {
             int_lin_eq::propagate(this);
+            if(_sumMin == _sumMax and _sumMin == _c)
+            {
+                setActive(false);
+            }
         }
     }
 }
\ No newline at end of file
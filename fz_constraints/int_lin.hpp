@@ -10,6 +10,9 @@ class int_lin : public Constraint
         std::vector<int> _as_neg;
         std::vector<var<int>::Ptr> _bs_pos;
         std::vector<var<int>::Ptr> _bs_neg;
+        std::vector<IntVarImpl*> _cs_pos; // The concrete variables of _bs_pos and _bs_neg (see concrete)
+        std::vector<IntVarImpl*> _cs_neg;
+        bool _concrete;                   // True when there are no views: the propagators then use _cs_pos and _cs_neg
         int _c;
         int _sumMin;
         int _sumMax;
@@ -21,7 +24,10 @@ class int_lin : public Constraint
     public:
         int_lin(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         static void calSumMinMax(int_lin* il);
+        template <class Vec> static void calSumMinMax(int_lin* il, const Vec& _bs_pos, const Vec& _bs_neg);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
+        bool explainFailure(std::vector<Literal>& reason) override;
 
     friend class int_lin_eq;
     friend class int_lin_ge;
@@ -37,6 +43,7 @@ class int_lin_reif : public int_lin
     public:
         int_lin_reif(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::vector<var<int>::Ptr>& int_vars, std::vector<var<bool>::Ptr>& bool_vars);
         void post() override;
+        bool explain(const Literal& l, std::vector<Literal>& reason) override;
 };
 
 class int_lin_eq : public int_lin
@@ -68,6 +75,7 @@ class int_lin_ge
 {
     public:
         static void propagate(int_lin* il, int c);
+        template <class Vec> static void propagate(int_lin* il, int c, const Vec& _bs_pos, const Vec& _bs_neg);
 };
 
 class int_lin_le : public int_lin
@@ -77,6 +85,7 @@ class int_lin_le : public int_lin
         void post() override;
         void propagate() override;
         static void propagate(int_lin* il);
+        template <class Vec> static void propagate(int_lin* il, const Vec& _bs_pos, const Vec& _bs_neg);
 };
 
 class int_lin_le_imp : public int_lin_reif
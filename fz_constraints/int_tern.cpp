@@ -8,7 +8,9 @@ int_tern::int_tern(CPSolver::Ptr cp, FlatZinc::Constraint& fzConstraint, std::ve
     _a(int_vars[fzConstraint.vars[0]]),
     _b(int_vars[fzConstraint.vars[1]]),
     _c(int_vars[fzConstraint.vars[2]])
-{}
+{
+    setPriority(BINARY);
+}
 
 
 void int_tern::calMulMinMax(int aMin, int aMax, int bMin, int bMax, int& min, int& max)
@@ -135,6 +135,18 @@ namespace FlatZinc
         {
             return largest;
         }
+        else if (str == TO_STRING(dom_w_deg))
+        {
+            return dom_w_deg;
+        }
+        else if (str == TO_STRING(activity))
+        {
+            return activity;
+        }
+        else if (str == TO_STRING(impact))
+        {
+            return impact;
+        }
         else
         {
             std::string error = "Unsupported variable selection: ";
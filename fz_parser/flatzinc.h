@@ -196,7 +196,10 @@ namespace FlatZinc
                 first_fail,
                 input_order,
                 smallest,
-                largest
+                largest,
+                dom_w_deg,
+                activity,
+                impact
             };
         enum ValueSelection
             {
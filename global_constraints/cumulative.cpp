@@ -9,13 +9,13 @@ Cumulative::Cumulative(Factory::Veci &sa,
 {
    for (auto& v : sa)
       s.push_back(v);
-   setPriority(CLOW);
+   setPriority(QUADRATIC);
 }  
 
 Cumulative::Cumulative(std::vector<var<int>::Ptr> & s, std::vector<int> const & p, std::vector<int> const & h, int c)
   : Constraint(s[0]->getSolver()), nActivities(s.size()), c(c), s(s),si(s.size()), p(p), h(h)
 {
-   setPriority(CLOW);
+   setPriority(QUADRATIC);
 }
 */
 
@@ -42,7 +42,7 @@ public:
   {
     for (auto& v : sa)
       s.push_back(v);
-    setPriority(CLOW); 
+    setPriority(QUADRATIC); 
   }
   void post() override;
   void propagate() override;
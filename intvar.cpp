@@ -17,6 +17,8 @@
 
 #include "intvar.hpp"
 #include "store.hpp"
+#include "lcg.hpp"
+#include "scores.hpp"
 #include <algorithm>
 
 void printVar(var<int>* x) {
@@ -34,19 +36,45 @@ IntVarImpl::IntVarImpl(CPSolver::Ptr& cps,int min,int max)
       _onBindList(cps->getStateManager(),cps->getStore()),
       _onBoundsList(cps->getStateManager(),cps->getStore()),
       _onDomList(cps->getStateManager(),cps->getStore()),
+      _onBoundsAdvisors(cps->getStateManager(),cps->getStore()),
+      _onDomAdvisors(cps->getStateManager(),cps->getStore()),
+      _wdeg(cps->getStateManager()),
       _domListener(new (cps) DomainListener(this))
 {}
 
+// Records the constraint a listener (or advisor) belongs to. Closures are attributed to the constraint being
+// posted or, when none, to the propagator running. Only the listeners added at the root count: the ones added
+// during the search (e.g., a clause moving its watches) are gone after a backtrack.
+void IntVarImpl::inScope(Constraint* c)
+{
+    if (_solver->getStateManager()->depth() > 0)
+        return;
+    Constraint* owner = _solver->owner();
+    if (owner == nullptr)
+        owner = c;
+    owner->inScope(&_wdeg);
+}
+
 class ClosureConstraint : public Constraint {
     std::function<void(void)> _f;
+    Constraint*           _owner;   // the constraint that added the closure (if any)
 public:
     ClosureConstraint(CPSolver::Ptr cp,std::function<void(void)>&& f)
         : Constraint(cp),
-          _f(std::move(f)) {}
+          _f(std::move(f)),
+          _owner(cp->owner()) {}
     void post() {}
     void propagate() {
         _f();
     }
+    // The failures of the closure are the failures of its owner (see var<int>::weightedDegree), unless the
+    // owner is inactive: its weight is then frozen
+    void incWeight() override {
+        if (_owner && _owner->isActive())
+            _owner->incWeight();
+        else
+            Constraint::incWeight();
+    }
 };
 
 TLCNode* IntVarImpl::whenBind(std::function<void(void)>&& f)
@@ -72,7 +100,14 @@ void IntVarImpl::assign(int v)
             printVar(this);
         }
     )
-    _dom->assign(v,*_domListener);
+    if (_solver->learner())
+        learn(Literal(getId(),Literal::EQ,v));
+    else if (advised()) {
+        const int oldMin = min(),oldMax = max(),oldSize = size();
+        _dom->assign(v,*_domListener);
+        advise(oldMin,oldMax,oldSize,v);
+    } else
+        _dom->assign(v,*_domListener);
 }
 void IntVarImpl::remove(int v)
 {
@@ -84,7 +119,14 @@ void IntVarImpl::remove(int v)
             printVar(this);
         }
     )
-    _dom->remove(v,*_domListener);
+    if (_solver->learner())
+        learn(Literal(getId(),Literal::NEQ,v));
+    else if (advised()) {
+        const int oldMin = min(),oldMax = max(),oldSize = size();
+        _dom->remove(v,*_domListener);
+        advise(oldMin,oldMax,oldSize,v);
+    } else
+        _dom->remove(v,*_domListener);
 }
 void IntVarImpl::removeBelow(int newMin)
 {
@@ -96,7 +138,14 @@ void IntVarImpl::removeBelow(int newMin)
             printVar(this);
         }
     )
-    _dom->removeBelow(newMin,*_domListener);
+    if (_solver->learner())
+        learn(Literal(getId(),Literal::GEQ,newMin));
+    else if (advised()) {
+        const int oldMin = min(),oldMax = max(),oldSize = size();
+        _dom->removeBelow(newMin,*_domListener);
+        advise(oldMin,oldMax,oldSize,newMin);
+    } else
+        _dom->removeBelow(newMin,*_domListener);
 }
 void IntVarImpl::removeAbove(int newMax)
 {
@@ -108,7 +157,14 @@ void IntVarImpl::removeAbove(int newMax)
             printVar(this);
         }
     )
-    _dom->removeAbove(newMax,*_domListener);
+    if (_solver->learner())
+        learn(Literal(getId(),Literal::LEQ,newMax));
+    else if (advised()) {
+        const int oldMin = min(),oldMax = max(),oldSize = size();
+        _dom->removeAbove(newMax,*_domListener);
+        advise(oldMin,oldMax,oldSize,newMax);
+    } else
+        _dom->removeAbove(newMax,*_domListener);
 }
 void IntVarImpl::updateBounds(int newMin,int newMax)
 {
@@ -118,6 +174,136 @@ void IntVarImpl::updateBounds(int newMin,int newMax)
     removeAbove(newMax);
 }
 
+// Bulk operations. Learning records every literal with its reason (hence one value at a time) and the advisors
+// are told of the values actually lost (the changes of bounds at once).
+void IntVarImpl::removeSet(const std::vector<int>& vals)
+{
+    if (_solver->learner())
+        var<int>::removeSet(vals);
+    else if (advised()) {
+        std::vector<int> lost;
+        for(int v : vals)
+            if (contains(v))
+                lost.push_back(v);
+        const int oldMin = min(),oldMax = max();
+        _dom->removeSet(lost,*_domListener);
+        advise(oldMin,oldMax,lost);
+    } else
+        _dom->removeSet(vals,*_domListener);
+}
+void IntVarImpl::restrictTo(const std::vector<int>& vals)
+{
+    if (_solver->learner())
+        var<int>::restrictTo(vals);
+    else if (advised()) {
+        std::vector<int> lost;
+        auto k = vals.begin();
+        for(int v = min();v <= max();v++) {
+            while (k != vals.end() && *k < v) ++k;
+            if ((k == vals.end() || *k != v) && contains(v))
+                lost.push_back(v);
+        }
+        removeSet(lost);
+    } else {
+        const int lo = vals.empty() ? max() + 1 : std::max(min(),vals.front());
+        const int hi = vals.empty() ? min() - 1 : std::min(max(),vals.back());
+        if (lo > hi)
+            failNow();
+        std::vector<unsigned long long> mask(((hi - lo) >> 6) + 1,0);
+        for(int v : vals)
+            if (lo <= v && v <= hi)
+                mask[(v - lo) >> 6] |= 1ULL << ((v - lo) & 0x3f);
+        _dom->intersectWith(lo,mask.data(),(int)mask.size(),*_domListener);
+    }
+}
+void IntVarImpl::intersectWith(int from,const std::vector<unsigned long long>& mask)
+{
+    if (_solver->learner())
+        var<int>::intersectWith(from,mask);
+    else if (advised()) {
+        std::vector<int> lost;
+        const long long to = from + 64LL * (long long)mask.size();
+        for(int v = min();v <= max();v++) {
+            const bool kept = v >= from && v < to && ((mask[(v - from) >> 6] >> ((v - from) & 0x3f)) & 0x1);
+            if (!kept && contains(v))
+                lost.push_back(v);
+        }
+        removeSet(lost);
+    } else
+        _dom->intersectWith(from,mask.data(),(int)mask.size(),*_domListener);
+}
+
+// Enforces `l` on the domain (with the advisors)
+void IntVarImpl::apply(const Literal& l)
+{
+    const int oldMin = min(),oldMax = max(),oldSize = size();
+    switch(l._rel) {
+        case Literal::EQ:  _dom->assign(l._val,*_domListener);break;
+        case Literal::NEQ: _dom->remove(l._val,*_domListener);break;
+        case Literal::LEQ: _dom->removeAbove(l._val,*_domListener);break;
+        default:           _dom->removeBelow(l._val,*_domListener);break;
+    }
+    if (advised())
+        advise(oldMin,oldMax,oldSize,l._val);
+}
+
+// Enforces `l` and records it with its reason (see LCG). Unregistered variables are not recorded.
+void IntVarImpl::learn(const Literal& l)
+{
+    LCG* lcg = _solver->learner();
+    if (l._var < 0)
+        apply(l);
+    else if (lcg->before(*this,l)) {
+        apply(l);
+        lcg->after(*this,l);
+    }
+}
+
+void IntVarImpl::advise(int oldMin,int oldMax,int oldSize,int v)
+{
+    if (size() == oldSize)
+        return;
+    const bool inside = min() == oldMin && max() == oldMax;
+    advise(inside ? IntDelta(oldMin,oldMax,v) : IntDelta(oldMin,oldMax,min(),max()));
+}
+
+// The values of `lost` that left the inside of the domain are advised one by one, then the change of bounds.
+void IntVarImpl::advise(int oldMin,int oldMax,const std::vector<int>& lost)
+{
+    const int newMin = min(),newMax = max();
+    for(int v : lost)
+        if (newMin < v && v < newMax)
+            advise(IntDelta(newMin,newMax,v));
+    if (newMin != oldMin || newMax != oldMax)
+        advise(IntDelta(oldMin,oldMax,newMin,newMax));
+}
+
+void IntVarImpl::advise(const IntDelta& d)
+{
+    auto notify = [this,&d](IntAdvisor& a) {
+                     if (!a._c->isActive())
+                         return false;
+                     if (a._c->advise(a._idx,d.map(a._a,a._b)))
+                         _solver->schedule(a._c);
+                     return true;
+                  };
+    _onDomAdvisors.filter(notify);
+    if (!d.inside())
+        _onBoundsAdvisors.filter(notify);
+}
+
+// Schedules the active constraints of the list. Entailed (inactive) constraints are detached as they are
+// met: later events no longer see them and backtracking restores them with their `active` flag.
+static inline void scheduleAll(CPSolver::Ptr& cps,trailList<Constraint::Ptr>& list)
+{
+    list.filter([&cps](Constraint::Ptr& c) {
+                   if (!c->isActive())
+                       return false;
+                   cps->schedule(c);
+                   return true;
+                });
+}
+
 void IntVarImpl::DomainListener::empty() 
 {
     failNow();
@@ -125,26 +311,25 @@ void IntVarImpl::DomainListener::empty()
 
 void IntVarImpl::DomainListener::bind() 
 {
-    for(auto& f : theVar->_onBindList)
-        theVar->_solver->schedule(f);
+    scheduleAll(theVar->_solver,theVar->_onBindList);
 }
 
 void IntVarImpl::DomainListener::change()  
 {
-    for(auto& f : theVar->_onDomList)
-        theVar->_solver->schedule(f);
+    theVar->_solver->notifyChange();
+    if (Scores* sc = theVar->_solver->scores())
+        sc->touch(theVar->getId());
+    scheduleAll(theVar->_solver,theVar->_onDomList);
 }
 
 void IntVarImpl::DomainListener::changeMin() 
 {
-    for(auto& f :  theVar->_onBoundsList)
-        theVar->_solver->schedule(f);
+    scheduleAll(theVar->_solver,theVar->_onBoundsList);
 }
 
 void IntVarImpl::DomainListener::changeMax() 
 {
-    for(auto& f :  theVar->_onBoundsList)
-        theVar->_solver->schedule(f);
+    scheduleAll(theVar->_solver,theVar->_onBoundsList);
 }
 
 namespace Factory {
@@ -162,10 +347,9 @@ namespace Factory {
       auto minVal = std::min(vals);
       auto maxVal = std::max(vals);
       auto var = makeIntVar(cps,minVal,maxVal);
-      for(int k=minVal;k <= maxVal;k++) {
-         if (std::find(vals.begin(),vals.end(),k) == vals.end())
-            var->remove(k);
-      }
+      std::vector<int> sorted(vals);
+      std::sort(sorted.begin(),sorted.end());
+      var->restrictTo(sorted);
       return var;
    }
 
@@ -175,21 +359,25 @@ namespace Factory {
         int minValue = values.front();
         int maxValue = values.back();
         auto var = makeIntVar(cps, minValue, maxValue);
-        int idx = 0;
-        for(int value = minValue; value <= maxValue; value += 1)
-        {
-            if (value == values[idx])
-            {
-                idx += 1;
-            }
-            else
-            {
-                var->remove(value);
-            }
-        }
+        var->restrictTo(values);
         return var;
     }
 
+    var<int>::Ptr affine(var<int>::Ptr x,int a,int b) {
+        assert(a != 0);
+        IntVarImpl* base;
+        if (auto v = dynamic_cast<IntVarViewAffine*>(x.get())) {   // a * (a' * y + b') + b is a view on y
+            base = v->base();
+            b += a * v->shift();
+            a *= v->scale();
+        } else
+            base = concrete(x);
+        assert(base != nullptr);
+        if (a == 1 && b == 0)
+            return base;
+        return new (x->getSolver()) IntVarViewAffine(base,a,b);
+    }
+
     var<bool>::Ptr makeBoolVar(CPSolver::Ptr cps)
     {
         var<bool>::Ptr rv = new (cps) var<bool>(cps);
@@ -35,6 +35,9 @@ class IntVarImpl :public var<int> {
    trailList<Constraint::Ptr> _onBindList;
    trailList<Constraint::Ptr> _onBoundsList;
    trailList<Constraint::Ptr> _onDomList;
+   trailList<IntAdvisor>      _onBoundsAdvisors;
+   trailList<IntAdvisor>      _onDomAdvisors;
+   WeightedDegree             _wdeg;
    struct DomainListener :public IntNotifier {
       IntVarImpl* theVar;
       DomainListener(IntVarImpl* x) : theVar(x) {}
@@ -45,31 +48,47 @@ class IntVarImpl :public var<int> {
       void changeMax() override;
    };
    DomainListener*       _domListener;
+   bool advised() const noexcept { return !_onDomAdvisors.empty() || !_onBoundsAdvisors.empty();}
+   void advise(const IntDelta& d);
+   void advise(int oldMin,int oldMax,int oldSize,int v);
+   void advise(int oldMin,int oldMax,const std::vector<int>& lost);
+   void apply(const Literal& l);
+   void learn(const Literal& l);
+   void inScope(Constraint* c);
 public:
    IntVarImpl(CPSolver::Ptr& cps,int min,int max);
    IntVarImpl(CPSolver::Ptr& cps,int n) : IntVarImpl(cps,0,n-1) {}
    Storage::Ptr getStore() override   { return _solver->getStore();}
    CPSolver::Ptr getSolver() override { return _solver;}
-   int min() const override { return _dom->min();}
-   int max() const override { return _dom->max();}
-   int size() const override { return _dom->size();}
-   bool isBound() const override { return _dom->isBound();}
-   bool contains(int v) const override { return _dom->member(v);}
-   bool containsBase(int v) const override { return _dom->memberBase(v);}
-   bool changed() const noexcept override  { return _dom->changed();}
+   int min() const final { return _dom->min();}
+   int max() const final { return _dom->max();}
+   int size() const final { return _dom->size();}
+   bool isBound() const final { return _dom->isBound();}
+   bool contains(int v) const final { return _dom->member(v);}
+   bool containsBase(int v) const final { return _dom->memberBase(v);}
+   bool changed() const noexcept final  { return _dom->changed();}
+   Literal literal(Literal::Rel rel,int v) const final { return Literal(getId(),rel,v);}
+   unsigned long weightedDegree() const final { return _wdeg.value();}
 
-   void assign(int v) override;
-   void remove(int v) override;
-   void removeBelow(int newMin) override;
-   void removeAbove(int newMax) override;
-   void updateBounds(int newMin,int newMax) override;
+   void assign(int v) final;
+   void remove(int v) final;
+   void removeBelow(int newMin) final;
+   void removeAbove(int newMax) final;
+   void updateBounds(int newMin,int newMax) final;
+   void removeSet(const std::vector<int>& vals) final;
+   void restrictTo(const std::vector<int>& vals) override;
+   void intersectWith(int from,const std::vector<unsigned long long>& mask) override;
    
    TLCNode* whenBind(std::function<void(void)>&& f) override;
    TLCNode* whenBoundsChange(std::function<void(void)>&& f) override;
    TLCNode* whenDomainChange(std::function<void(void)>&& f) override;
-   TLCNode* propagateOnBind(Constraint::Ptr c)  override         { return _onBindList.emplace_back(std::move(c));}
-   TLCNode* propagateOnBoundChange(Constraint::Ptr c)  override  { return _onBoundsList.emplace_back(std::move(c));}
-   TLCNode* propagateOnDomainChange(Constraint::Ptr c ) override { return _onDomList.emplace_back(std::move(c));}
+   TLCNode* propagateOnBind(Constraint::Ptr c)  override         { inScope(c.get());return _onBindList.emplace_back(std::move(c));}
+   TLCNode* propagateOnBoundChange(Constraint::Ptr c)  override  { inScope(c.get());return _onBoundsList.emplace_back(std::move(c));}
+   TLCNode* propagateOnDomainChange(Constraint::Ptr c ) override { inScope(c.get());return _onDomList.emplace_back(std::move(c));}
+   TLANode* addAdvisor(IntAdvisor a,bool domain) override {
+      inScope(a._c.get());
+      return domain ? _onDomAdvisors.emplace_back(std::move(a)) : _onBoundsAdvisors.emplace_back(std::move(a));
+   }
 
     std::ostream& print(std::ostream& os) const override {
        // if (size() == 1)
@@ -80,40 +99,6 @@ public:
     }
 };
 
-class IntVarViewOpposite :public var<int> {
-   var<int>::Ptr _x;
-public:
-   IntVarViewOpposite(const var<int>::Ptr& x) : _x(x) {}
-   Storage::Ptr getStore() override   { return _x->getStore();}
-   CPSolver::Ptr getSolver() override { return _x->getSolver();}
-   int min() const  override { return - _x->max();}
-   int max() const  override { return - _x->min();}
-   int size() const override { return _x->size();}
-   bool isBound() const override { return _x->isBound();}
-   bool contains(int v) const override { return _x->contains(-v);}
-   bool changed() const noexcept override  { return _x->changed();}
-   
-   void assign(int v) override { _x->assign(-v);}
-   void remove(int v) override { _x->remove(-v);}
-   void removeBelow(int newMin) override { _x->removeAbove(-newMin);}
-   void removeAbove(int newMax) override { _x->removeBelow(-newMax);}
-   void updateBounds(int newMin,int newMax) override { _x->updateBounds(-newMax,-newMin);}
-   
-   TLCNode* whenBind(std::function<void(void)>&& f) override { return _x->whenBind(std::move(f));}
-   TLCNode* whenBoundsChange(std::function<void(void)>&& f) override { return _x->whenBoundsChange(std::move(f));}
-   TLCNode* whenDomainChange(std::function<void(void)>&& f) override { return _x->whenDomainChange(std::move(f));}
-   TLCNode* propagateOnBind(Constraint::Ptr c)          override { return _x->propagateOnBind(c);}
-   TLCNode* propagateOnBoundChange(Constraint::Ptr c)   override { return _x->propagateOnBoundChange(c);}
-   TLCNode* propagateOnDomainChange(Constraint::Ptr c ) override { return _x->propagateOnDomainChange(c);}
-   std::ostream& print(std::ostream& os) const override {
-      os << '{';
-      for(int i = min();i <= max() - 1;i++) 
-         if (contains(i)) os << i << ',';
-      if (size()>0) os << max();
-      return os << '}';      
-   }
-};
-
 static inline int floorDiv(int a,int b) {
    const int q = a/b;
    return (a < 0 && q * b != a) ? q - 1 : q;
@@ -124,97 +109,90 @@ static inline int ceilDiv(int a,int b) {
 }
 
 /**
- * @brief The class is meant to represent a multiplicative (affine) view.
+ * @brief The class is meant to represent an affine view.
  *
- * Namely, this variable (\f$y\f$)
- * stands for \f$y = a * x\f$ (where \f$a\f$ is a constant).
- * The affine view can be used anywhere where a conventional variable is expected.
+ * Namely, this variable (\f$y\f$) stands for \f$y = a * x + b\f$ (where \f$a \neq 0\f$ and \f$b\f$ are
+ * constants). The affine view can be used anywhere where a conventional variable is expected.
  * Note that the variable registers Observers and callbacks with variable \f$x\f$.
+ *
+ * Views are not stacked: the view of a view is the composition of the two maps over the same variable
+ * (see Factory::affine), so that \f$x\f$ is always an IntVarImpl whose (final) methods the view calls
+ * directly. Any chain of opposites, offsets and scalings costs one indirection.
  */
-class IntVarViewMul :public var<int> {
-    var<int>::Ptr _x;
-    int _a;
+class IntVarViewAffine :public var<int> {
+   IntVarImpl* _x;
+   int _a,_b;
+   int toX(int v) const { return (v - _b) / _a;}             // when a divides v - b
+   bool reaches(int v) const { return (v - _b) % _a == 0;}   // some value of x maps to v
 public:
    /**
-    * Constructor that takes a variable and  a constant and creates the muliplicative view
+    * Constructor that takes a variable and two constants and creates the view
     * @param x the source variable to view
-    * @param a the scaling constant (multiplier)
+    * @param a the scaling constant (multiplier, not 0)
+    * @param b the additive shift
     */
-   IntVarViewMul(const var<int>::Ptr& x,int a) : _x(x),_a(a) { assert(a> 0);}
+   IntVarViewAffine(IntVarImpl* x,int a,int b) : _x(x),_a(a),_b(b) { assert(a != 0);}
+   IntVarImpl* base() const noexcept { return _x;}
+   int scale() const noexcept        { return _a;}
+   int shift() const noexcept        { return _b;}
    Storage::Ptr getStore() override   { return _x->getStore();}
    CPSolver::Ptr getSolver() override { return _x->getSolver();}
-   int min() const  override { return _a * _x->min();}
-   int max() const  override { return _a * _x->max();}
+   int min() const  override { return _a > 0 ? _a * _x->min() + _b : _a * _x->max() + _b;}
+   int max() const  override { return _a > 0 ? _a * _x->max() + _b : _a * _x->min() + _b;}
    int size() const override { return _x->size();}
    bool isBound() const override { return _x->isBound();}
-   bool contains(int v) const override { return (v % _a != 0) ? false : _x->contains(v / _a);}
+   bool contains(int v) const override { return reaches(v) && _x->contains(toX(v));}
    bool changed() const noexcept override  { return _x->changed();}
-   
+   Literal literal(Literal::Rel rel,int v) const override {
+      switch(rel) {
+         case Literal::LEQ: return _a > 0 ? _x->literal(Literal::LEQ,floorDiv(v - _b,_a))
+                                          : _x->literal(Literal::GEQ,ceilDiv(_b - v,-_a));
+         case Literal::GEQ: return _a > 0 ? _x->literal(Literal::GEQ,ceilDiv(v - _b,_a))
+                                          : _x->literal(Literal::LEQ,floorDiv(_b - v,-_a));
+         default: return reaches(v) ? _x->literal(rel,toX(v)) : Literal();   // a*x+b != v always holds
+      }
+   }
+   unsigned long weightedDegree() const override { return _x->weightedDegree();}
+
    void assign(int v) override {
-      if (v % _a == 0)
-         _x->assign(v / _a);
+      if (reaches(v))
+         _x->assign(toX(v));
       else failNow();
    }
    void remove(int v) override {
-      if (v % _a == 0)
-         _x->remove(v / _a);
+      if (reaches(v))
+         _x->remove(toX(v));
    }
-   void removeBelow(int v) override { _x->removeBelow(ceilDiv(v,_a));}
-   void removeAbove(int v) override { _x->removeAbove(floorDiv(v,_a));}
-   void updateBounds(int min,int max) override { _x->updateBounds(ceilDiv(min,_a),floorDiv(max,_a));}   
-   TLCNode* whenBind(std::function<void(void)>&& f) override { return _x->whenBind(std::move(f));}
-   TLCNode* whenBoundsChange(std::function<void(void)>&& f) override { return _x->whenBoundsChange(std::move(f));}
-   TLCNode* whenDomainChange(std::function<void(void)>&& f) override { return _x->whenDomainChange(std::move(f));}
-   TLCNode* propagateOnBind(Constraint::Ptr c)          override { return _x->propagateOnBind(c);}
-   TLCNode* propagateOnBoundChange(Constraint::Ptr c)   override { return _x->propagateOnBoundChange(c);}
-   TLCNode* propagateOnDomainChange(Constraint::Ptr c ) override { return _x->propagateOnDomainChange(c);}
-   std::ostream& print(std::ostream& os) const override {
-      os << '{';
-      for(int i = min();i <= max() - 1;i++) 
-         if (contains(i)) os << i << ',';
-      if (size()>0) os << max();
-      return os << '}';      
+   void removeBelow(int v) override {
+      if (_a > 0)
+         _x->removeBelow(ceilDiv(v - _b,_a));
+      else _x->removeAbove(floorDiv(_b - v,-_a));
+   }
+   void removeAbove(int v) override {
+      if (_a > 0)
+         _x->removeAbove(floorDiv(v - _b,_a));
+      else _x->removeBelow(ceilDiv(_b - v,-_a));
+   }
+   void updateBounds(int min,int max) override {
+      if (_a > 0)
+         _x->updateBounds(ceilDiv(min - _b,_a),floorDiv(max - _b,_a));
+      else _x->updateBounds(ceilDiv(_b - max,-_a),floorDiv(_b - min,-_a));
+   }
+   void removeSet(const std::vector<int>& vals) override {
+      std::vector<int> xv;
+      xv.reserve(vals.size());
+      for(int v : vals)
+         if (reaches(v))
+            xv.push_back(toX(v));
+      _x->removeSet(xv);
    }
-};
-
-/**
- * @brief The class is meant to represent an additive (affine) view.
- *
- * Namely, this variable (\f$y\f$)
- * stands for \f$y = x + o\f$ (where \f$o\f$ is a constant).
- * The affine view can be used anywhere where a conventional variable is expected.
- * Note that the variable registers Observers and callbacks with variable \f$x\f$.
- */
-class IntVarViewOffset : public var<int> {
-    var<int>::Ptr _x;
-    int _o;
-public:
-   /**
-    * Constructor that takes a variable and  a constant and creates the additive views
-    * @param x the source variable to view
-    * @param o the additive shift   
-    */
-   IntVarViewOffset(const var<int>::Ptr& x,int o) : _x(x),_o(o) {}
-   Storage::Ptr getStore() override   { return _x->getStore();}
-   CPSolver::Ptr getSolver() override { return _x->getSolver();}
-   int min() const  override { return _o + _x->min();}
-   int max() const  override { return _o + _x->max();}
-   int size() const override { return _x->size();}
-   bool isBound() const override { return _x->isBound();}
-   bool contains(int v) const override { return _x->contains(v - _o);}
-   bool changed() const noexcept override  { return _x->changed();}
-   
-   void assign(int v) override { _x->assign(v - _o);}
-   void remove(int v) override { _x->remove(v - _o);}
-   void removeBelow(int v) override { _x->removeBelow(v - _o);}
-   void removeAbove(int v) override { _x->removeAbove(v - _o);}
-   void updateBounds(int min,int max) override { _x->updateBounds(min - _o,max - _o);}   
    TLCNode* whenBind(std::function<void(void)>&& f) override { return _x->whenBind(std::move(f));}
    TLCNode* whenBoundsChange(std::function<void(void)>&& f) override { return _x->whenBoundsChange(std::move(f));}
    TLCNode* whenDomainChange(std::function<void(void)>&& f) override { return _x->whenDomainChange(std::move(f));}
    TLCNode* propagateOnBind(Constraint::Ptr c)          override { return _x->propagateOnBind(c);}
    TLCNode* propagateOnBoundChange(Constraint::Ptr c)   override { return _x->propagateOnBoundChange(c);}
    TLCNode* propagateOnDomainChange(Constraint::Ptr c ) override { return _x->propagateOnDomainChange(c);}
+   TLANode* addAdvisor(IntAdvisor a,bool domain) override { return _x->addAdvisor(IntAdvisor { a._c,a._idx,a._a * _a,a._a * _b + a._b },domain);}
    std::ostream& print(std::ostream& os) const override {
       os << '{';
       for(int i = min();i <= max() - 1;i++) 
@@ -281,6 +259,14 @@ inline std::ostream& operator<<(std::ostream& os,const var<bool>::Ptr& xp) {
     return xp->print(os);
 }
 
+/**
+ * The accessors and updates of IntVarImpl are final: through an `IntVarImpl*` they are direct calls that
+ * the compiler inlines, rather than virtual calls on var<int>. Hot propagators (Sum, LessOrEqual, EQBinBC)
+ * look it up once, instantiate their code for both cases and dispatch on the cached pointers.
+ * @return the variable itself when it is an IntVarImpl, `nullptr` for a view (or any other implementation)
+ */
+inline IntVarImpl* concrete(var<int>::Ptr x) { return dynamic_cast<IntVarImpl*>(x.get());}
+
 /** 
  * Convenience output operator<< to print a C++ vector (STL) of variables.
  * @param os the stream to print to
@@ -395,12 +381,21 @@ namespace Factory {
     */
    var<bool>::Ptr makeBoolVar(CPSolver::Ptr cps);
    var<bool>::Ptr makeBoolVar(CPSolver::Ptr cps, bool value);
+   /**
+    * Factory method. Creates an affine view on the given integer variable `x`. Namely, it returns `a * x + b`
+    * @param x the variable to be viewed
+    * @param a the scaling coefficient
+    * @param b the additive shift
+    * @return `a * x + b`. When `x` is a view itself, the result is a single view (the composition of the two)
+    * on the variable `x` views. It is `x` itself when the map is the identity.
+    */
+   var<int>::Ptr affine(var<int>::Ptr x,int a,int b);
    /**
     * Factory method. Creates an opposite view on the given integer variable `x`. Namely, it returns `-x`
     * @param x the variable to be viewed
     * @return -x the opposite of `x`
     */
-   inline var<int>::Ptr minus(var<int>::Ptr x)     { return new (x->getSolver()) IntVarViewOpposite(x);}
+   inline var<int>::Ptr minus(var<int>::Ptr x)     { return affine(x,-1,0);}
    /**
     * Factory operator. Creates an opposite view on the given integer variable `x`. Namely, it returns `-x`
     * @param x the variable to be viewed
@@ -418,11 +413,7 @@ namespace Factory {
    inline var<int>::Ptr operator*(var<int>::Ptr x,int a) {
       if (a == 0)
          return makeIntVar(x->getSolver(),0,0);
-      else if (a==1)
-         return x;
-      else if (a <0)
-         return minus(new (x->getSolver()) IntVarViewMul(x,-a));
-      else return new (x->getSolver()) IntVarViewMul(x,a);
+      else return affine(x,a,0);
    }
    /**
     * Factory operator. Creates a multiplicative view on the given integer variable `x`. Namely, it returns `a * x`
@@ -435,10 +426,10 @@ namespace Factory {
    inline var<int>::Ptr operator*(int a,var<int>::Ptr x) { return x * a;}
    inline var<int>::Ptr operator*(var<bool>::Ptr x,int a)  { return Factory::operator*((var<int>::Ptr)x,a);}
    inline var<int>::Ptr operator*(int a,var<bool>::Ptr x)  { return x * a;}
-   inline var<int>::Ptr operator+(var<int>::Ptr x,int a) { return new (x->getSolver()) IntVarViewOffset(x,a);}
-   inline var<int>::Ptr operator+(int a,var<int>::Ptr x) { return new (x->getSolver()) IntVarViewOffset(x,a);}
-   inline var<int>::Ptr operator-(var<int>::Ptr x,const int a) { return new (x->getSolver()) IntVarViewOffset(x,-a);}
-   inline var<int>::Ptr operator-(const int a,var<int>::Ptr x) { return new (x->getSolver()) IntVarViewOffset(-x,a);}
+   inline var<int>::Ptr operator+(var<int>::Ptr x,int a) { return affine(x,1,a);}
+   inline var<int>::Ptr operator+(int a,var<int>::Ptr x) { return affine(x,1,a);}
+   inline var<int>::Ptr operator-(var<int>::Ptr x,const int a) { return affine(x,1,-a);}
+   inline var<int>::Ptr operator-(const int a,var<int>::Ptr x) { return affine(x,-1,a);}
    /**
     * Factory method. Allocates an array of integer variables to be used on the solver
     * @param cps the owner of the array
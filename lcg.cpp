@@ -0,0 +1,501 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "lcg.hpp"
+#include "fail.hpp"
+#include <algorithm>
+#include <limits>
+
+LCG::LCG(CPSolver* cp)
+   : _cp(cp),
+     _sm(cp->getStateManager()),
+     _size(_sm,0),
+     _nbReasons(_sm,0),
+     _nbDecisions(_sm,0),
+     _qhead(_sm,0),
+     _inc(1.0),
+     _nbLive(0),
+     _maxLearned(2000),
+     _tag(-1),
+     _tagLit(-1),
+     _from(0),
+     _kind(Decision),
+     _hasConflict(false),
+     _fallback(false),
+     _level(0),
+     _counter(0),
+     _nbDecMarked(0),
+     _ok(true),
+     _stats {0,0,0,0}
+{
+   CPSolver::Ptr p = cp;
+   _prop = new (p) Propagator(p,this);
+   for(int id = 0;id < (int)cp->getNbVars();id++)
+      ensure(id);
+}
+
+bool LCG::Propagator::explain(const Literal& l,std::vector<Literal>& reason)
+{
+   _lcg->explainClause(reason);
+   return true;
+}
+
+// The clause being propagated implies its literal `_tagLit` because all the others are false.
+void LCG::explainClause(std::vector<Literal>& reason) const
+{
+   if (_tag < 0)
+      return;           // a unit clause holds unconditionally
+   const auto& lits = _clauses[_tag]._lits;
+   for(int k = 0;k < (int)lits.size();k++)
+      if (k != _tagLit)
+         reason.push_back(~lits[k]);
+}
+
+bool LCG::isTrue(const Literal& l) const
+{
+   const var<int>* x = at(l._var);
+   switch(l._rel) {
+      case Literal::EQ:  return x->isBound() && x->min() == l._val;
+      case Literal::NEQ: return !x->contains(l._val);
+      case Literal::LEQ: return x->max() <= l._val;
+      default:           return x->min() >= l._val;
+   }
+}
+
+void LCG::ensure(int id)
+{
+   while ((int)_last.size() <= id)
+      _last.emplace_back(_sm,-1);
+   if ((int)_root.size() <= id)
+      _root.resize(id + 1,Root {0,0,false});
+}
+
+bool LCG::before(const var<int>& x,const Literal& l)
+{
+   bool wipes;
+   switch(l._rel) {
+      case Literal::EQ:
+         if (x.isBound() && x.min() == l._val) return false;
+         wipes = !x.contains(l._val);
+         break;
+      case Literal::NEQ:
+         if (!x.contains(l._val)) return false;
+         wipes = x.isBound();
+         break;
+      case Literal::LEQ:
+         if (l._val >= x.max()) return false;
+         wipes = l._val < x.min();
+         break;
+      default:
+         if (l._val <= x.min()) return false;
+         wipes = l._val > x.max();
+         break;
+   }
+   Root& r = _root[l._var];
+   if (!r._known)
+      r = Root { x.min(),x.max(),true };
+   Constraint* c = _cp->running();
+   _from = _nbReasons;
+   _reasons.resize(_from);
+   _buf.clear();
+   if (c == nullptr || _sm->depth() == 0)
+      _kind = Decision;
+   else if (trusted(c) && c->explain(l,_buf)) {
+      _kind = Explained;
+      _reasons.insert(_reasons.end(),_buf.begin(),_buf.end());
+   } else
+      _kind = Fallback;
+   if (wipes && c != nullptr) {
+      // the reason of `l` and the literal that contradicts it
+      _conflict = _buf;
+      _fallback = _kind == Fallback;
+      switch(l._rel) {
+         case Literal::EQ:
+            if (l._val < x.min())      _conflict.emplace_back(l._var,Literal::GEQ,x.min());
+            else if (l._val > x.max()) _conflict.emplace_back(l._var,Literal::LEQ,x.max());
+            else _conflict.emplace_back(l._var,Literal::NEQ,l._val);
+            break;
+         case Literal::NEQ: _conflict.emplace_back(l._var,Literal::EQ,l._val);break;
+         case Literal::LEQ: _conflict.emplace_back(l._var,Literal::GEQ,x.min());break;
+         default:           _conflict.emplace_back(l._var,Literal::LEQ,x.max());break;
+      }
+      _hasConflict = true;
+   }
+   return true;
+}
+
+void LCG::after(const var<int>& x,const Literal& l)
+{
+   const int id = l._var;
+   const int e = _size;
+   const int level = _sm->depth();
+   const int to = (int)_reasons.size();
+   _entries.resize(e);
+   _entries.push_back(Entry { l,x.min(),x.max(),_last[id],level,_from,to,
+                              _cp->running() == _prop.get() ? _tag : -1,_kind });
+   _size = e + 1;
+   _nbReasons = to;
+   _last[id] = e;
+   if (_kind == Decision && level > 0) {
+      _decisions.resize(_nbDecisions);
+      _decisions.push_back(e);
+      _nbDecisions = _nbDecisions + 1;
+   }
+   if (id < (int)_watches.size() && !_watches[id].empty())
+      _cp->schedule(_prop);
+}
+
+void LCG::prepare()
+{
+   _hasConflict = false;
+   if (!_pending.empty() || !_units.empty())
+      _cp->schedule(_prop);
+}
+
+// The oldest entry (before `before`) from which `l` holds. -1 when `l` held before the first update
+// of its variable and -2 when `l` does not hold.
+int LCG::find(const Literal& l,int before) const
+{
+   const int id = l._var;
+   int at = -1;
+   if (id < (int)_last.size())
+      for(int e = _last[id];e >= 0;e = _entries[e]._prev) {
+         if (e >= before)
+            continue;
+         const Entry& x = _entries[e];
+         bool holds;
+         switch(l._rel) {
+            case Literal::EQ:  holds = x._min == l._val && x._max == l._val;break;
+            case Literal::NEQ:
+               if (x._lit == l)
+                  return e;    // the value was in the domain before its removal
+               holds = l._val < x._min || l._val > x._max;
+               break;
+            case Literal::LEQ: holds = x._max <= l._val;break;
+            default:           holds = x._min >= l._val;break;
+         }
+         if (holds)
+            at = e;
+         else if (l._rel != Literal::NEQ)
+            break;     // the bounds only tighten: the older updates do not entail `l` either
+      }
+   if (at >= 0)
+      return at;
+   if (id >= (int)_root.size() || !_root[id]._known)
+      return -1;
+   const Root& r = _root[id];
+   switch(l._rel) {
+      case Literal::EQ:  return r._min == l._val && r._max == l._val ? -1 : -2;
+      case Literal::NEQ: return -1;    // outside the root bounds or a hole of the root domain
+      case Literal::LEQ: return r._max <= l._val ? -1 : -2;
+      default:           return r._min >= l._val ? -1 : -2;
+   }
+}
+
+// The depth at which `l` became true (0 when it holds at the root).
+int LCG::levelOf(const Literal& l) const
+{
+   const int e = find(l,_size);
+   return e >= 0 ? _entries[e]._level : 0;
+}
+
+static bool entails(const Literal& a,const Literal& b)
+{
+   if (a == b)
+      return true;
+   switch(a._rel) {
+      case Literal::EQ:
+         switch(b._rel) {
+            case Literal::EQ:  return false;
+            case Literal::NEQ: return a._val != b._val;
+            case Literal::LEQ: return a._val <= b._val;
+            default:           return a._val >= b._val;
+         }
+      case Literal::LEQ:
+         return (b._rel == Literal::LEQ && a._val <= b._val) || (b._rel == Literal::NEQ && a._val < b._val);
+      case Literal::GEQ:
+         return (b._rel == Literal::GEQ && a._val >= b._val) || (b._rel == Literal::NEQ && a._val > b._val);
+      default:
+         return false;
+   }
+}
+
+void LCG::mark(int e)
+{
+   if (_seen[e])
+      return;
+   _seen[e] = 1;
+   const Entry& x = _entries[e];
+   if (x._level == 0)
+      return;
+   _nbDecMarked += x._kind == Decision;
+   if (x._level == _level)
+      _counter += 1;
+   else
+      _learned.push_back(~x._lit);
+}
+
+// Resolves `l` on the entries that made it true. When the update that made it true does not entail
+// `l` alone (e.g., x != v made x == w), the earlier updates of the variable are needed too.
+void LCG::visit(const Literal& l,int before)
+{
+   if (l._var < 0)
+      return;
+   const int e = find(l,before);
+   if (e == -2)
+      _ok = false;
+   else if (e >= 0) {
+      if (entails(_entries[e]._lit,l))
+         mark(e);
+      else
+         for(int k = e;k >= 0;k = _entries[k]._prev)
+            mark(k);
+   }
+}
+
+void LCG::visitDecisions(int before)
+{
+   for(int k = 0;k < _nbDecisions && _decisions[k] < before;k++)
+      mark(_decisions[k]);
+}
+
+void LCG::expand(int e)
+{
+   const Entry& x = _entries[e];
+   switch(x._kind) {
+      case Explained:
+         for(int k = x._from;k < x._to && _ok;k++)
+            visit(_reasons[k],e);
+         break;
+      case Fallback:
+         visitDecisions(e);
+         break;
+      default: break;
+   }
+   if (x._clause >= 0)
+      bump(x._clause);
+}
+
+void LCG::bump(int ci)
+{
+   LClause& c = _clauses[ci];
+   if (c._dead)
+      return;
+   c._act += _inc;
+   if (c._act > 1e100) {
+      for(auto& ck : _clauses)
+         ck._act *= 1e-100;
+      _inc *= 1e-100;
+   }
+}
+
+void LCG::analyze(Constraint* running)
+{
+   const bool recorded = _hasConflict;
+   _hasConflict = false;
+   _level = _sm->depth();
+   if (_level == 0 || running == nullptr)
+      return;
+   if (!recorded) {
+      _conflict.clear();
+      _fallback = false;
+      if (!trusted(running) || !running->explainFailure(_conflict))
+         return;        // the nogood would only be the current path
+   }
+   _stats.conflicts += 1;
+   _learned.clear();
+   _seen.assign(_size,0);
+   _counter = _nbDecMarked = 0;
+   _ok = true;
+   for(const Literal& l : _conflict)
+      visit(l,_size);
+   if (_fallback)
+      visitDecisions(_size);
+   for(int e = _size - 1;_ok && _counter > 0;e--) {
+      if (!_seen[e])
+         continue;
+      const Entry& x = _entries[e];
+      _counter -= 1;
+      if (_counter == 0 || x._kind == Decision)
+         _learned.push_back(~x._lit);
+      else
+         expand(e);
+   }
+   // a nogood on every decision only forbids the current path, which the search leaves anyway
+   if (_ok && !_learned.empty() && _nbDecMarked < _nbDecisions)
+      learn();
+   _inc /= 0.999;
+}
+
+void LCG::learn()
+{
+   _stats.learned += 1;
+   if (_learned.size() == 1) {
+      _units.push_back(_learned[0]);
+      return;
+   }
+   for(const Literal& l : _learned)
+      if (l._var >= (int)_watches.size())
+         _watches.resize(l._var + 1);
+   _clauses.push_back(LClause { _learned,{0,1},_inc,false });
+   _pending.push_back((int)_clauses.size() - 1);
+   if (++_nbLive > _maxLearned)
+      reduce();
+}
+
+// Deletes the least active half of the learned clauses (binary clauses are kept)
+void LCG::reduce()
+{
+   std::vector<int> idx;
+   for(int k = 0;k < (int)_clauses.size();k++)
+      if (!_clauses[k]._dead && _clauses[k]._lits.size() > 2)
+         idx.push_back(k);
+   std::sort(idx.begin(),idx.end(),[this](int a,int b) { return _clauses[a]._act < _clauses[b]._act;});
+   for(std::size_t k = 0;k < idx.size() / 2;k++) {
+      LClause& c = _clauses[idx[k]];
+      c._dead = true;
+      std::vector<Literal>().swap(c._lits);
+   }
+   _nbLive -= idx.size() / 2;
+   _stats.deleted += idx.size() / 2;
+   _maxLearned += _maxLearned / 10;
+}
+
+// Watches the two literals that are not false or, failing that, that became false last.
+void LCG::attach(int ci)
+{
+   LClause& c = _clauses[ci];
+   if (c._dead)
+      return;
+   const int n = (int)c._lits.size();
+   int w[2] = {-1,-1},key[2] = {-1,-1};
+   for(int k = 0;k < n;k++) {
+      const int kk = isFalse(c._lits[k]) ? levelOf(~c._lits[k]) : std::numeric_limits<int>::max();
+      if (kk > key[0]) {
+         w[1] = w[0];key[1] = key[0];
+         w[0] = k;key[0] = kk;
+      } else if (kk > key[1]) {
+         w[1] = k;key[1] = kk;
+      }
+   }
+   c._w[0] = w[0];
+   c._w[1] = w[1];
+   const int x0 = c._lits[w[0]]._var,x1 = c._lits[w[1]]._var;
+   _watches[x0].push_back(ci);
+   if (x1 != x0)
+      _watches[x1].push_back(ci);
+   if (key[0] != std::numeric_limits<int>::max())
+      conflict(c);
+   else if (key[1] != std::numeric_limits<int>::max() && !isTrue(c._lits[w[0]]))
+      enforce(ci,w[0]);
+}
+
+void LCG::conflict(const LClause& c)
+{
+   _conflict.clear();
+   for(const Literal& l : c._lits)
+      _conflict.push_back(~l);
+   _fallback = false;
+   _hasConflict = true;
+   failNow();
+}
+
+void LCG::set(const Literal& l)
+{
+   var<int>* x = at(l._var);
+   _stats.propagated += 1;
+   switch(l._rel) {
+      case Literal::EQ:  x->assign(l._val);break;
+      case Literal::NEQ: x->remove(l._val);break;
+      case Literal::LEQ: x->removeAbove(l._val);break;
+      default:           x->removeBelow(l._val);break;
+   }
+}
+
+void LCG::enforce(int ci,int k)
+{
+   _tag = ci;
+   _tagLit = k;
+   set(_clauses[ci]._lits[k]);
+   _tag = _tagLit = -1;
+}
+
+void LCG::wake(int id)
+{
+   if (id >= (int)_watches.size())
+      return;
+   auto& ws = _watches[id];
+   for(std::size_t k = 0;k < ws.size();) {
+      const int ci = ws[k];
+      LClause& c = _clauses[ci];
+      if (c._dead) {
+         ws[k] = ws.back();
+         ws.pop_back();
+         continue;
+      }
+      for(int w = 0;w < 2;w++) {
+         const Literal& l = c._lits[c._w[w]];
+         if (l._var != id || !isFalse(l))
+            continue;
+         const int o = c._w[1 - w];
+         if (isTrue(c._lits[o]))
+            break;
+         int j = -1;
+         for(int i = 0;i < (int)c._lits.size() && j < 0;i++)
+            if (i != c._w[0] && i != c._w[1] && !isFalse(c._lits[i]))
+               j = i;
+         if (j >= 0) {
+            c._w[w] = j;
+            const int y = c._lits[j]._var;
+            if (y != id && y != c._lits[o]._var)
+               _watches[y].push_back(ci);
+         } else if (isFalse(c._lits[o]))
+            conflict(c);
+         else {
+            enforce(ci,o);
+            break;
+         }
+      }
+      if (c._lits[c._w[0]]._var != id && c._lits[c._w[1]]._var != id) {
+         ws[k] = ws.back();
+         ws.pop_back();
+      } else
+         k++;
+   }
+}
+
+void LCG::propagate()
+{
+   while (!_pending.empty()) {
+      const int ci = _pending.back();
+      _pending.pop_back();
+      attach(ci);
+   }
+   for(const Literal& u : _units)
+      if (!isTrue(u)) {
+         if (isFalse(u)) {
+            _conflict.assign(1,~u);
+            _fallback = false;
+            _hasConflict = true;
+            failNow();
+         }
+         set(u);
+      }
+   while (_qhead < _size) {
+      const int e = _qhead;
+      _qhead = e + 1;
+      wake(_entries[e]._lit._var);
+   }
+}
@@ -0,0 +1,212 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __LCG_H
+#define __LCG_H
+
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include "literal.hpp"
+#include "trailable.hpp"
+#include "varitf.hpp"
+
+/**
+ * @brief Lazy clause generation (see CPSolver::setLearning).
+ *
+ * While learning is on, every update of a domain is recorded on a trail of literals (\f$x = v\f$,
+ * \f$x \neq v\f$, \f$x \leq v\f$ or \f$x \geq v\f$) together with its reason: the literals the
+ * propagator relied on (see Constraint::explain). Explanations are eager: they are computed when
+ * the update is made. Updates made outside of a propagator (at a depth greater than 0) are decisions.
+ * A propagator that cannot explain an update is charged with all the decisions taken so far, so
+ * the conflicts it takes part in are seldom learned: learning pays off on models whose propagators
+ * are explained (the linear, element, boolean and clause propagators used by FlatZinc models are).
+ *
+ * When a fixpoint fails, the conflict is resolved backward along the trail down to its first unique
+ * implication point (1-UIP) and the resulting nogood is learned as a clause. The learned clauses
+ * are propagated with two watched literals. They carry an activity, bumped whenever they take part
+ * in a conflict, and the least active half is deleted whenever there are too many of them.
+ *
+ * Learning supports the searches that explore the tree depth-first from the root (DFSearch,
+ * RestartSearch and LNS) and must be turned on at the root, before the model is posted.
+ * Only the constraints posted at the root are trusted to explain their propagations.
+ */
+class LCG {
+public:
+   enum Kind : char { Decision, Explained, Fallback };
+   /**
+    * @brief One update of a domain.
+    */
+   struct Entry {
+      Literal _lit;
+      int     _min,_max;    // bounds of the variable after the update
+      int     _prev;        // previous entry on the same variable (-1 for none)
+      int     _level;       // depth of the search when the update was made
+      int     _from,_to;    // the reason is _reasons[_from,_to)
+      int     _clause;      // learned clause that propagated the update (-1 for none)
+      Kind    _kind;
+   };
+   /**
+    * @brief Counters of the learning.
+    */
+   struct Statistics {
+      unsigned long long conflicts;   //!< conflicts analyzed
+      unsigned long long learned;     //!< clauses learned
+      unsigned long long deleted;     //!< learned clauses deleted by the reductions
+      unsigned long long propagated;  //!< literals enforced by the learned clauses
+      friend std::ostream& operator<<(std::ostream& os,const Statistics& s) {
+         return os << "Conflicts = " << s.conflicts << std::endl
+                   << "Learned Clauses = " << s.learned << std::endl
+                   << "Deleted Clauses = " << s.deleted << std::endl
+                   << "Clause Propagations = " << s.propagated << std::endl;
+      }
+   };
+private:
+   struct LClause {
+      std::vector<Literal> _lits;
+      int                  _w[2];   // the watched literals
+      double               _act;
+      bool                 _dead;
+   };
+   /**
+    * The propagator of the learned clauses. It is scheduled by the updates of watched variables.
+    */
+   class Propagator : public Constraint {
+      LCG* _lcg;
+   public:
+      Propagator(CPSolver::Ptr cp,LCG* lcg) : Constraint(cp),_lcg(lcg) { setPriority(LINEAR);}
+      void post() override {}
+      void propagate() override { _lcg->propagate();}
+      bool explain(const Literal& l,std::vector<Literal>& reason) override;
+   };
+   struct Root { int _min,_max; bool _known; };   // the domain before the first update
+   CPSolver*                     _cp;
+   Trailer::Ptr                  _sm;
+   Constraint::Ptr               _prop;
+   std::vector<Entry>            _entries;
+   trail<int>                    _size;
+   std::vector<Literal>          _reasons;
+   trail<int>                    _nbReasons;
+   std::vector<int>              _decisions;     // indices of the decision entries
+   trail<int>                    _nbDecisions;
+   std::deque<trail<int>>        _last;          // last entry of every variable
+   std::vector<Root>             _root;
+   trail<int>                    _qhead;         // next entry whose variable the clauses must see
+   std::unordered_set<const Constraint*> _untrusted;
+   std::vector<LClause>          _clauses;
+   std::vector<std::vector<int>> _watches;       // per variable
+   std::vector<int>              _pending;       // clauses learned but not attached yet
+   std::vector<Literal>          _units;
+   double                        _inc;
+   std::size_t                   _nbLive;
+   std::size_t                   _maxLearned;
+   int                           _tag;           // clause propagating (-1 for a unit)
+   int                           _tagLit;        // the literal it enforces
+   // the update in progress (see before/after)
+   int                           _from;
+   Kind                          _kind;
+   std::vector<Literal>          _buf;
+   // conflict analysis
+   bool                          _hasConflict;
+   bool                          _fallback;      // the conflict also depends on every decision
+   std::vector<Literal>          _conflict;
+   std::vector<Literal>          _learned;
+   std::vector<char>             _seen;
+   int                           _level;
+   int                           _counter;
+   int                           _nbDecMarked;
+   bool                          _ok;
+   Statistics                    _stats;
+
+   var<int>* at(int id) const { return static_cast<var<int>*>(_cp->varAt(id).get());}
+   bool isTrue(const Literal& l) const;
+   bool isFalse(const Literal& l) const { return isTrue(~l);}
+   bool trusted(const Constraint* c) const { return _untrusted.empty() || _untrusted.find(c) == _untrusted.end();}
+   int  find(const Literal& l,int before) const;
+   int  levelOf(const Literal& l) const;
+   void mark(int e);
+   void visit(const Literal& l,int before);
+   void visitDecisions(int before);
+   void expand(int e);
+   void bump(int ci);
+   void learn();
+   void reduce();
+   void attach(int ci);
+   void wake(int id);
+   void set(const Literal& l);
+   void enforce(int ci,int k);
+   void conflict(const LClause& c);
+   void explainClause(std::vector<Literal>& reason) const;
+public:
+   LCG(CPSolver* cp);
+   /**
+    * Called when a variable is registered with the solver (the variables are tracked from the root).
+    */
+   void ensure(int id);
+   /**
+    * Called by a variable before it enforces `l` on itself: records the reason of the update and,
+    * when the update wipes the domain out, the conflict.
+    * @return false if the update would not change the domain
+    */
+   bool before(const var<int>& x,const Literal& l);
+   /**
+    * Called by a variable once it enforced `l` on itself.
+    */
+   void after(const var<int>& x,const Literal& l);
+   /**
+    * Called at the start of every fixpoint (schedules the clause propagator when it has work).
+    */
+   void prepare();
+   /**
+    * Called when a fixpoint fails: learns a clause from the conflict (if it can be explained).
+    * @param running the propagator that failed (if any)
+    */
+   void analyze(Constraint* running);
+   void propagate();
+   /**
+    * Excludes `c` from the explanations: it was posted below the root and only holds in that subtree.
+    */
+   void distrust(const Constraint* c) { _untrusted.insert(c);}
+   /**
+    * Sets the number of learned clauses kept before the first reduction (it grows by 10% with every reduction).
+    */
+   void setMaxLearned(std::size_t n) noexcept { _maxLearned = n;}
+   const Statistics& statistics() const noexcept { return _stats;}
+   /**
+    * Adds the bounds of `x` to a reason.
+    */
+   static void bounds(const var<int>::Ptr& x,std::vector<Literal>& reason) {
+      reason.push_back(x->literal(Literal::GEQ,x->min()));
+      reason.push_back(x->literal(Literal::LEQ,x->max()));
+   }
+   /**
+    * Adds the domain of `x` (its bounds and the holes between them) to a reason.
+    */
+   static void domain(const var<int>::Ptr& x,std::vector<Literal>& reason) {
+      bounds(x,reason);
+      for(int v = x->min() + 1;v < x->max();v++)
+         if (!x->contains(v))
+            reason.push_back(x->literal(Literal::NEQ,v));
+   }
+   /**
+    * Adds the bounds of every variable of `x` to a reason.
+    */
+   template <class Vec> static void allBounds(const Vec& x,std::vector<Literal>& reason) {
+      for(const auto& xi : x)
+         bounds(xi,reason);
+   }
+};
+
+#endif
@@ -46,6 +46,7 @@ public:
         _u(x[0]->getSolver()->getStateManager(),0),
         _sz((int)x.size())
    {
+      setPriority(LINEAR);
       int i = 0;
       for(auto& xi : x) _x[i++] = xi;
       i = 0;
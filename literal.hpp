@@ -0,0 +1,58 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __LITERAL_H
+#define __LITERAL_H
+
+#include <iostream>
+
+/**
+ * @brief A solver-independent description of an atomic decision \f$x \; op \; v\f$.
+ * Decisions use \f$=\f$, \f$\neq\f$ and, when splitting domains, the bounds \f$x \leq v\f$ and
+ * \f$x \geq v\f$. Lazy clause generation uses all four (see LCG).
+ *
+ * The variable is designated by its identifier (the rank at which it was registered
+ * with its solver) rather than by a pointer. Two solvers built by the same model code
+ * assign the same identifiers, so a literal recorded in one solver can be replayed
+ * in the other.
+ * @see Factory::decision
+ */
+struct Literal {
+   enum Rel : char { EQ = 0, NEQ = 1, LEQ = 2, GEQ = 3 };
+   int  _var;
+   Rel  _rel;
+   int  _val;
+   Literal() : _var(-1),_rel(EQ),_val(0) {}
+   Literal(int var,Rel rel,int val) : _var(var),_rel(rel),_val(val) {}
+   /**
+    * Returns the negation of the literal (\f$x=v\f$ becomes \f$x \neq v\f$ and vice versa,
+    * \f$x \leq v\f$ becomes \f$x \geq v+1\f$ and vice versa)
+    */
+   Literal operator~() const noexcept {
+      switch(_rel) {
+         case EQ:  return Literal(_var,NEQ,_val);
+         case NEQ: return Literal(_var,EQ,_val);
+         case LEQ: return Literal(_var,GEQ,_val + 1);
+         default:  return Literal(_var,LEQ,_val - 1);
+      }
+   }
+   bool operator==(const Literal& l) const noexcept { return _var == l._var && _rel == l._rel && _val == l._val;}
+   friend std::ostream& operator<<(std::ostream& os,const Literal& l) {
+      static const char* ops[] = { " == "," != "," <= "," >= " };
+      return os << 'x' << l._var << ops[l._rel] << l._val;
+   }
+};
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "lns.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+void RandomNeighborhood::relax(LNS& lns,int nbFree)
+{
+   const auto& x = lns.variables();
+   const auto& best = lns.best();
+   std::vector<int> idx(x.size());
+   std::iota(idx.begin(),idx.end(),0);
+   std::shuffle(idx.begin(),idx.end(),lns.rng());
+   for(std::size_t k = nbFree;k < idx.size();k++)
+      x[idx[k]]->assign(best[idx[k]]);
+   lns.solver()->fixpoint();
+}
+
+void PropagationGuidedNeighborhood::relax(LNS& lns,int nbFree)
+{
+   const auto& x = lns.variables();
+   const auto& best = lns.best();
+   const int n = (int)x.size();
+   std::vector<int> before(n);
+   std::vector<int> free;
+   int next = -1;
+   while (true) {
+      free.clear();
+      for(int i = 0;i < n;i++)
+         if (!x[i]->isBound())
+            free.push_back(i);
+      if ((int)free.size() <= nbFree)
+         break;
+      const int j = next >= 0 && !x[next]->isBound() ? next : free[lns.rng()() % free.size()];
+      for(int i : free)
+         before[i] = x[i]->size();
+      x[j]->assign(best[j]);
+      lns.solver()->fixpoint();
+      double most = 0;              // the largest relative reduction caused by the fixpoint
+      next = -1;
+      for(int i : free)
+         if (i != j && !x[i]->isBound()) {
+            double r = 1.0 - (double)x[i]->size() / before[i];
+            if (r > most) {
+               most = r;
+               next = i;
+            }
+         }
+   }
+}
+
+void CostImpactNeighborhood::relax(LNS& lns,int nbFree)
+{
+   const auto& x = lns.variables();
+   const auto& best = lns.best();
+   const int n = (int)x.size();
+   auto obj = lns.objective();
+   _impact.resize(n,0.0);
+   _nbSamples.resize(n,0);
+   std::vector<int> idx(n);
+   std::iota(idx.begin(),idx.end(),0);
+   std::shuffle(idx.begin(),idx.end(),lns.rng());   // random order among equal impacts
+   std::stable_sort(idx.begin(),idx.end(),[this](int a,int b) { return _impact[a] > _impact[b];});
+   std::shuffle(idx.begin() + std::min(nbFree,n),idx.end(),lns.rng());
+   for(int k = nbFree;k < n;k++) {
+      const int j = idx[k];
+      if (x[j]->isBound())
+         continue;
+      const int bound = obj->value();
+      x[j]->assign(best[j]);
+      lns.solver()->fixpoint();
+      const double delta = obj->isMin() ? obj->value() - bound : bound - obj->value();
+      _impact[j] = (_impact[j] * _nbSamples[j] + delta) / (_nbSamples[j] + 1);
+      _nbSamples[j] += 1;
+   }
+}
+
+std::ostream& operator<<(std::ostream& os,const LNSStatistics& s)
+{
+   os << std::fixed << std::setprecision(3)
+      << "LNS " << s.elapsed << "s iterations = " << s.iterations << " improvements = " << s.improvements;
+   if (s.hasSolution)
+      os << " best = " << s.best << (s.optimal ? " (optimal)" : "");
+   os << " relaxed = " << s.nbFree << std::endl;
+   for(const auto& op : s.operators)
+      os << "   " << std::setw(12) << op.name << " calls = " << op.calls
+         << " improvements = " << op.improvements << " weight = " << op.weight << std::endl;
+   return os;
+}
+
+void LNS::init()
+{
+   _bestValue = 0;
+   _hasSolution = _optimal = false;
+   _iterations = _improvements = 0;
+   _failLimit = 100;
+   _rate = 0.2;
+   _period = 0;
+   _best.resize(_x.size());
+   _dfs.onSolution([this] {
+                      for(std::size_t i = 0;i < _x.size();i++)
+                         _best[i] = _x[i]->min();
+                      _bestValue = _obj->value();
+                      _hasSolution = true;
+                   });
+}
+
+void LNS::add(Neighborhood::Ptr op)
+{
+   _ops.push_back(op);
+   _weights.push_back(1.0);
+   _calls.push_back(0);
+   _wins.push_back(0);
+}
+
+void LNS::reportEvery(double seconds,std::function<void(const LNSStatistics&)> cb)
+{
+   _period = seconds;
+   _report = cb ? cb : [](const LNSStatistics& s) { std::cout << s;};
+}
+
+int LNS::pick()
+{
+   double total = 0;
+   for(double w : _weights)
+      total += w;
+   double r = std::uniform_real_distribution<double>(0,total)(_rng);
+   for(std::size_t k = 0;k < _weights.size();k++) {
+      if (r < _weights[k])
+         return (int)k;
+      r -= _weights[k];
+   }
+   return (int)_weights.size() - 1;
+}
+
+int LNS::nbFree() const noexcept
+{
+   const int n = (int)_x.size();
+   return std::max(1,std::min(n,(int)std::lround(_rate * n)));
+}
+
+LNSStatistics LNS::statistics() const
+{
+   LNSStatistics s;
+   s.elapsed = RuntimeMonitor::elapsedSeconds(_start);
+   s.iterations = _iterations;
+   s.improvements = _improvements;
+   s.hasSolution = _hasSolution;
+   s.best = _bestValue;
+   s.optimal = _optimal;
+   s.nbFree = nbFree();
+   for(std::size_t k = 0;k < _ops.size();k++)
+      s.operators.push_back({ _ops[k]->name(),_calls[k],_wins[k],_weights[k] });
+   return s;
+}
+
+SearchStatistics LNS::optimize(Limit limit)
+{
+   const double reaction = 0.2;   // how fast the weights of the operators follow their recent success
+   SearchStatistics stats;
+   stats.setIntVars(_cp->getNbVars());
+   stats.setPropagators(_cp->getNbProp());
+   if (_ops.empty())
+      add(std::make_shared<RandomNeighborhood>());
+   _start = RuntimeMonitor::now();
+   double nextReport = _period;
+   auto within = [&stats,&limit](const SearchStatistics& ss) {
+                    SearchStatistics all = stats;
+                    all.merge(ss);
+                    all.setSolutions(stats.numberOfSolutions() + ss.numberOfSolutions());
+                    return limit(all);
+                 };
+   auto absorb = [&stats](const SearchStatistics& ss) {
+                    stats.merge(ss);
+                    stats.setSolutions(stats.numberOfSolutions() + ss.numberOfSolutions());
+                 };
+   auto ss = _dfs.optimizeSubjectTo(_obj,[&within](const SearchStatistics& ss) {
+                                            return ss.numberOfSolutions() >= 1 || within(ss);
+                                         },[] {});
+   absorb(ss);
+   _iterations += 1;
+   bool exhausted = ss.getCompleted();   // the first sub-search explored the whole search space
+   const int n = (int)_x.size();
+   while (_hasSolution && !exhausted && !limit(stats)) {
+      const int k = pick();
+      const int free = nbFree();
+      Neighborhood::Ptr op = _ops[k];
+      ss = _dfs.optimizeSubjectTo(_obj,[this,&within](const SearchStatistics& ss) {
+                                          return ss.numberOfFailures() >= _failLimit || within(ss);
+                                       },[this,op,free,n] {
+                                          if (free < n)
+                                             op->relax(*this,free);
+                                       });
+      absorb(ss);
+      _iterations += 1;
+      _calls[k] += 1;
+      const bool improved = ss.numberOfSolutions() > 0;
+      if (improved) {
+         _improvements += 1;
+         _wins[k] += 1;
+      }
+      _weights[k] = std::max(0.01,(1 - reaction) * _weights[k] + reaction * (improved ? 1.0 : 0.0));
+      if (ss.getCompleted()) {            // the neighborhood was exhausted
+         if (free >= n)
+            exhausted = true;
+         else if (!improved)
+            _rate = std::min(1.0,_rate * 1.1);
+      } else if (!improved)
+         _rate = std::max(1.0 / n,_rate / 1.1);
+      if (_period > 0 && RuntimeMonitor::elapsedSeconds(_start) >= nextReport) {
+         _report(statistics());
+         nextReport += _period;
+      }
+   }
+   _optimal = _hasSolution && exhausted;
+   if (!exhausted)
+      stats.setNotCompleted();
+   stats.setSolveTime();
+   stats.setPropagations(_cp->getPropagations());
+   stats.setAvoidedWakeups(_cp->getAvoidedWakeups());
+   if (_period > 0)
+      _report(statistics());
+   return stats;
+}
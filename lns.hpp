@@ -0,0 +1,189 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __LNS_H
+#define __LNS_H
+
+#include <vector>
+#include <random>
+#include <memory>
+#include "search.hpp"
+
+class LNS;
+
+/**
+ * @brief A neighborhood operator of LNS.
+ *
+ * It restricts the search space around the incumbent by fixing part of the variables to their
+ * value in the incumbent. The other variables are relaxed.
+ */
+class Neighborhood {
+public:
+   typedef std::shared_ptr<Neighborhood> Ptr;
+   virtual ~Neighborhood() {}
+   virtual const char* name() const noexcept = 0;
+   /**
+    * Fixes all the variables of `lns` but (about) `nbFree` of them to their value in the incumbent.
+    * It runs at the root of the sub-search and may fail.
+    */
+   virtual void relax(LNS& lns,int nbFree) = 0;
+};
+
+/**
+ * @brief Relaxes variables drawn uniformly at random.
+ */
+class RandomNeighborhood : public Neighborhood {
+public:
+   const char* name() const noexcept override { return "random";}
+   void relax(LNS& lns,int nbFree) override;
+};
+
+/**
+ * @brief Propagation-guided neighborhood (Perron, Shaw and Furnon, 2004).
+ *
+ * Variables are fixed one at a time, with a fixpoint after each. The next variable to fix is the
+ * one whose domain the last fixpoint reduced the most (a random one when no domain changed), so
+ * that the variables left free are those the constraints tie together. Fixing stops once at most
+ * `nbFree` variables are unbound.
+ */
+class PropagationGuidedNeighborhood : public Neighborhood {
+public:
+   const char* name() const noexcept override { return "propagation";}
+   void relax(LNS& lns,int nbFree) override;
+};
+
+/**
+ * @brief Relaxes the variables whose value in the incumbent costs the most.
+ *
+ * Every variable carries the average amount by which fixing it to its incumbent value moved the
+ * bound of the objective (measured every time the operator fixed it). The `nbFree` variables with
+ * the largest impact are relaxed (ties are broken at random) and the others are fixed.
+ */
+class CostImpactNeighborhood : public Neighborhood {
+   std::vector<double> _impact;
+   std::vector<int>    _nbSamples;
+public:
+   const char* name() const noexcept override { return "cost-impact";}
+   void relax(LNS& lns,int nbFree) override;
+};
+
+/**
+ * @brief Progress of an LNS run.
+ */
+struct LNSStatistics {
+   struct Operator {
+      const char* name;
+      long        calls;
+      long        improvements;
+      double      weight;
+   };
+   double                elapsed;       //!< seconds since the start of the run
+   long                  iterations;    //!< sub-searches run so far (the first one included)
+   long                  improvements;  //!< sub-searches that improved the incumbent
+   bool                  hasSolution;
+   int                   best;          //!< objective value of the incumbent
+   bool                  optimal;       //!< the incumbent was proven optimal
+   int                   nbFree;        //!< variables the next neighborhood relaxes
+   std::vector<Operator> operators;
+   friend std::ostream& operator<<(std::ostream& os,const LNSStatistics& s);
+};
+
+/**
+ * @brief Large neighborhood search over DFSearch::optimizeSubjectTo.
+ *
+ * A first sub-search finds an initial solution. Every following iteration picks a neighborhood
+ * operator, lets it fix all but a few variables to their value in the incumbent and runs a
+ * sub-search limited to a number of failures to improve on the incumbent.
+ * With several operators, each iteration draws one with a probability proportional to its weight
+ * and the weights follow the success of the operators (adaptive LNS). The number of relaxed
+ * variables adapts too: it grows when sub-searches exhaust their neighborhood without improving
+ * and shrinks when they reach their failure limit. A sub-search that relaxes every variable and
+ * completes proves the incumbent optimal.
+ */
+class LNS {
+   CPSolver::Ptr                  _cp;
+   std::vector<var<int>::Ptr>     _x;
+   Objective::Ptr                 _obj;
+   DFSearch                       _dfs;
+   std::vector<Neighborhood::Ptr> _ops;
+   std::vector<double>            _weights;
+   std::vector<long>              _calls;
+   std::vector<long>              _wins;
+   std::vector<int>               _best;
+   int                            _bestValue;
+   bool                           _hasSolution;
+   bool                           _optimal;
+   long                           _iterations;
+   long                           _improvements;
+   std::mt19937                   _rng;
+   long                           _failLimit;
+   double                         _rate;     // fraction of the variables relaxed
+   double                         _period;   // seconds between two reports (0 for none)
+   std::function<void(const LNSStatistics&)> _report;
+   RuntimeMonitor::HRClock        _start;
+   void init();
+   int  pick();
+   int  nbFree() const noexcept;
+public:
+   /**
+    * @param cp the solver
+    * @param x the decision variables: neighborhoods fix and relax them
+    * @param obj the objective to optimize
+    * @param b the branching of the sub-searches
+    * @param seed the seed of the random generator of the operators
+    */
+   template <class Vec> LNS(CPSolver::Ptr cp,const Vec& x,Objective::Ptr obj,std::function<Branches(void)>&& b,
+                            unsigned int seed = 0)
+      : _cp(cp),_obj(obj),_dfs(cp,std::move(b)),_rng(seed) {
+      for(auto xi : x)
+         _x.push_back(xi);
+      init();
+   }
+   /**
+    * Adds a neighborhood operator. Random neighborhoods are used when none was added.
+    */
+   void add(Neighborhood::Ptr op);
+   /**
+    * Limits every sub-search (but the first) to `limit` failures (100 by default).
+    */
+   void setFailureLimit(long limit) noexcept { _failLimit = limit;}
+   /**
+    * Sets the fraction of the variables the first neighborhood relaxes (0.2 by default).
+    */
+   void setRelaxation(double rate) noexcept { _rate = rate;}
+   /**
+    * Reports the progress of the search every `seconds` seconds (checked between two sub-searches)
+    * and once more when it ends. Reports go to `std::cout` when no callback is given.
+    */
+   void reportEvery(double seconds,std::function<void(const LNSStatistics&)> cb = nullptr);
+   template <class B> void onSolution(B c) { _dfs.onSolution(std::move(c));}
+   CPSolver::Ptr solver() noexcept { return _cp;}
+   Objective::Ptr objective() noexcept { return _obj;}
+   const std::vector<var<int>::Ptr>& variables() const noexcept { return _x;}
+   /**
+    * The values of the variables in the incumbent.
+    */
+   const std::vector<int>& best() const noexcept { return _best;}
+   std::mt19937& rng() noexcept { return _rng;}
+   LNSStatistics statistics() const;
+   /**
+    * Runs until the limit (evaluated on the statistics accumulated over all the sub-searches) is
+    * reached or until the incumbent is proven optimal.
+    * @return the accumulated statistics (not completed unless optimality or infeasibility was proven)
+    */
+   SearchStatistics optimize(Limit limit);
+};
+
+#endif
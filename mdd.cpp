@@ -60,7 +60,7 @@ MDD::MDD(CPSolver::Ptr cp)
    _firstTime(trail,true)
 {
    mem = new Storage(trail);
-   setPriority(Constraint::CLOW);
+   setPriority(Constraint::GLOBAL);
    _posting = true;
    _mddspec.setConstraintPrioritySize(1);
    _nf = new (mem) MDDNodeFactory(mem,trail,std::numeric_limits<int>::max());
@@ -29,13 +29,6 @@ class MDDNode;
 
 class MDDEdge {
 public:
-   template <class U> class TrailEntry : public Entry {
-      U* _at;
-      U  _old;
-   public:
-      TrailEntry(U* ptr) : _at(ptr),_old(*ptr) {}
-      void restore() noexcept { *_at = _old;}
-   };
    typedef handle_ptr<MDDEdge> Ptr;
    MDDEdge(MDDNode* parent, MDDNode* child, int value, unsigned short childPosition,unsigned int parentPosition)
       : value(value), parent(parent), child(child),
@@ -47,11 +40,11 @@ public:
    unsigned short getParentPosition() const noexcept    { return parentPosition;}
    unsigned int getChildPosition() const noexcept       { return childPosition;}
    void setParentPosition(Trailer::Ptr t,unsigned int pos) noexcept {
-      t->trail(new (t) TrailEntry<unsigned int>(&parentPosition));
+      t->save(&parentPosition);
       parentPosition = pos;
    }
    void setChildPosition(Trailer::Ptr t,unsigned short  pos) noexcept  {
-      t->trail(new (t) TrailEntry<unsigned short>(&childPosition));
+      t->save(&childPosition);
       childPosition = pos;
    }
    MDDNode* getChild() const noexcept   { return child;}
@@ -68,13 +61,6 @@ private:
 class MDDNodeFactory;
 class MDDNode {
    friend class MDDNodeFactory;
-   template <class U> class TrailEntry : public Entry {
-      U* _at;
-      U  _old;
-   public:
-      TrailEntry(U* ptr) : _at(ptr),_old(*ptr) {}
-      void restore() noexcept { *_at = _old;}
-   };
    MDDNode(int nid,Storage::Ptr mem, Trailer::Ptr t,const MDDState& down,const MDDState& up,const MDDState& combined,int dsz,unsigned layer, int id);
 public:
    const auto& getParents()  noexcept  { return parents;}
@@ -108,7 +94,7 @@ public:
    }
    void setLayer(unsigned short l,Storage::Ptr mem) {
       auto t = children.getTrail();
-      t->trail(new (t) TrailEntry<unsigned short>(&layer));
+      t->save(&layer);
       layer = l;
    }
    MDDPack pack() { return MDDPack(downState,upState,combinedState);}
@@ -123,7 +109,7 @@ public:
    int getId() const noexcept                { return _nid;}
    void setPosition(int p,Storage::Ptr mem) {
       auto t = children.getTrail();
-      t->trail(new (t) TrailEntry<int>(&pos));
+      t->save(&pos);
       pos = p;
    }
    void clearQueue() const noexcept { _inQueue = None;}
@@ -144,12 +130,12 @@ public:
    bool isActive() const noexcept { return _active;}
    void deactivate() {
       auto t = children.getTrail();
-      t->trail(new (t) TrailEntry<bool>(&_active));
+      t->save(&_active);
       _active = false;
    }
    void activate() {
       auto t = children.getTrail();
-      t->trail(new (t) TrailEntry<bool>(&_active));
+      t->save(&_active);
       _active = true;
       _inQueue = None;
       _fq = _bq = nullptr;
@@ -199,7 +185,7 @@ public:
 inline void MDDEdge::moveTo(MDDNode* n,Trailer::Ptr t,Storage::Ptr mem) 
 {
    child->unhookChild(this);
-   t->trail(new (t) TrailEntry<MDDNode*>(&child));
+   t->save(&child);
    child = n;
    child->hookChild(this,mem);
    assert(n->isActive());
@@ -1212,7 +1212,7 @@ bool MDDRelax::updateCombinedIncrUp(MDDNode* n)
    return changed;
 }
 
-int __nbn = 0,__nbf = 0;
+__thread int __nbn = 0,__nbf = 0;
 
 void MDDRelax::computeDown(int iter)
 {
@@ -1227,6 +1227,11 @@ class MDDState {  // An actual state of an MDDNode.
          memcpy(_at->_mem,_from,_sz);
          _at->_flags = _f;
       }
+      bool regions(const std::function<void(void*,std::size_t)>& f) const override {
+         f(_at->_mem,_sz);
+         f(&_at->_flags,sizeof(Flags));
+         return true;
+      }
    };
 public:
    MDDState(Trailer::Ptr trail,MDDStateSpec* s,char* b,enum Direction dir,bool relax=false,bool unused=false) 
@@ -0,0 +1,149 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "profiler.hpp"
+#include "acstr.hpp"
+#include <typeinfo>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <map>
+#include <cxxabi.h>
+#include <stdlib.h>
+
+static std::string className(const Constraint* c)
+{
+   const char* raw = typeid(*c).name();
+   int status = 0;
+   char* name = abi::__cxa_demangle(raw,nullptr,nullptr,&status);
+   std::string s = status == 0 ? name : raw;
+   free(name);
+   return s;
+}
+
+void Profiler::enter(const Constraint* c,unsigned long long changes)
+{
+   if (_cur)
+      stop(false,changes);
+   auto at = _stats.find(c->getId());
+   if (at == _stats.end())
+      at = _stats.emplace(c->getId(),Stats { className(c),c,_stats.size(),0,0,0,1,0.0 }).first;
+   _cur = &at->second;
+   _changes = changes;
+   _start = std::chrono::steady_clock::now();
+}
+
+void Profiler::stop(bool failed,unsigned long long changes)
+{
+   _cur->seconds  += std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+   _cur->calls    += 1;
+   _cur->prunings += changes != _changes;
+   _cur->failures += failed;
+   _cur = nullptr;
+}
+
+static void byTime(std::vector<Profiler::Stats>& v)
+{
+   std::sort(v.begin(),v.end(),[](const Profiler::Stats& a,const Profiler::Stats& b) {
+                                  return a.seconds > b.seconds;
+                               });
+}
+
+std::vector<Profiler::Stats> Profiler::instances() const
+{
+   std::vector<Stats> v;
+   for(const auto& e : _stats)
+      v.push_back(e.second);
+   byTime(v);
+   return v;
+}
+
+std::vector<Profiler::Stats> Profiler::classes() const
+{
+   std::map<std::string,Stats> byName;
+   for(const auto& e : _stats) {
+      const Stats& s = e.second;
+      auto at = byName.find(s.name);
+      if (at == byName.end())
+         byName.emplace(s.name,Stats { s.name,nullptr,0,s.calls,s.prunings,s.failures,1,s.seconds });
+      else {
+         at->second.calls     += s.calls;
+         at->second.prunings  += s.prunings;
+         at->second.failures  += s.failures;
+         at->second.instances += 1;
+         at->second.seconds   += s.seconds;
+      }
+   }
+   std::vector<Stats> v;
+   for(const auto& e : byName)
+      v.push_back(e.second);
+   byTime(v);
+   return v;
+}
+
+static void printJSON(std::ostream& os,const Profiler::Stats& s,bool instance)
+{
+   os << "{ \"class\" : \"" << s.name << "\"";
+   if (instance)
+      os << ", \"instance\" : " << s.id;
+   else
+      os << ", \"instances\" : " << s.instances;
+   os << ", \"calls\" : " << s.calls << ", \"prunings\" : " << s.prunings
+      << ", \"failures\" : " << s.failures << ", \"seconds\" : " << s.seconds << " }";
+}
+
+void Profiler::print(std::ostream& os,Format fmt,int top) const
+{
+   const auto cls = classes();
+   const auto ins = instances();
+   double total = 0;
+   for(const auto& s : cls)
+      total += s.seconds;
+   const auto flags = os.flags();
+   os << std::fixed << std::setprecision(6);
+   if (fmt == JSON) {
+      os << "{\n\t\"seconds\" : " << total << ",\n\t\"classes\" : [";
+      for(auto i = 0u;i < cls.size();i++) {
+         os << (i ? ",\n\t\t" : "\n\t\t");
+         printJSON(os,cls[i],false);
+      }
+      os << "\n\t],\n\t\"instances\" : [";
+      for(auto i = 0u;i < ins.size();i++) {
+         os << (i ? ",\n\t\t" : "\n\t\t");
+         printJSON(os,ins[i],true);
+      }
+      os << "\n\t]\n}\n";
+   } else {
+      auto line = [&os,total](const std::string& name,const Stats& s) {
+                     os << std::left << std::setw(32) << name.substr(0,31) << std::right
+                        << std::setw(10) << s.instances << std::setw(12) << s.calls
+                        << std::setw(12) << s.prunings << std::setw(10) << s.failures
+                        << std::setw(12) << std::setprecision(4) << s.seconds
+                        << std::setw(8) << std::setprecision(1) << (total > 0 ? 100 * s.seconds / total : 0.0) << "\n";
+                  };
+      os << std::left << std::setw(32) << "Propagator" << std::right << std::setw(10) << "Instances"
+         << std::setw(12) << "Calls" << std::setw(12) << "Prunings" << std::setw(10) << "Failures"
+         << std::setw(12) << "Seconds" << std::setw(8) << "%" << "\n";
+      for(const auto& s : cls)
+         line(s.name,s);
+      os << "Most expensive instances:\n";
+      for(int i = 0;i < top && i < (int)ins.size();i++) {
+         std::ostringstream name;
+         name << ins[i].name << '#' << ins[i].id;
+         line(name.str(),ins[i]);
+      }
+   }
+   os.flags(flags);
+}
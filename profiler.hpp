@@ -0,0 +1,82 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+class Constraint;
+
+/**
+ * @brief Per-propagator profile of the fixpoints of a solver (see CPSolver::setProfiling).
+ *
+ * Every run of a propagator is accounted to its instance and to its class: the number of calls,
+ * of calls that pruned at least one domain, of calls that failed and the time spent.
+ */
+class Profiler {
+public:
+   enum Format { Table, JSON };
+   struct Stats {
+      std::string        name;       //!< the class of the propagator
+      const Constraint*  instance;   //!< `nullptr` for the totals of a class (backtracking may reuse its storage)
+      unsigned long      id;         //!< instances are numbered in the order of their first run
+      unsigned long long calls;
+      unsigned long long prunings;   //!< calls that updated a domain
+      unsigned long long failures;   //!< calls that failed
+      unsigned long long instances;  //!< instances of the class (1 for an instance)
+      double             seconds;
+   };
+private:
+   std::unordered_map<unsigned long,Stats>     _stats;   // by Constraint::getId
+   Stats*                                      _cur;
+   unsigned long long                          _changes;
+   std::chrono::steady_clock::time_point       _start;
+   void stop(bool failed,unsigned long long changes);
+public:
+   Profiler() : _cur(nullptr),_changes(0) {}
+   /**
+    * Called before a run of `c`.
+    * @param changes the number of domain updates so far
+    */
+   void enter(const Constraint* c,unsigned long long changes);
+   /**
+    * Called once `c` returns (at the latest before the next `enter`).
+    */
+   void leave(unsigned long long changes) { if (_cur) stop(false,changes);}
+   /**
+    * Called when a propagator fails (the failure is accounted to the running propagator, if any).
+    */
+   void fail(unsigned long long changes)  { if (_cur) stop(true,changes);}
+   void clear() { _stats.clear(); _cur = nullptr;}
+   /**
+    * @return the profile of each propagator instance (most expensive first)
+    */
+   std::vector<Stats> instances() const;
+   /**
+    * @return the profile of each propagator class (most expensive first)
+    */
+   std::vector<Stats> classes() const;
+   /**
+    * Prints the profile: the classes, then the `top` most expensive instances (all of them in JSON).
+    */
+   void print(std::ostream& os,Format fmt = Table,int top = 10) const;
+};
+
+#endif
@@ -0,0 +1,584 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "psearch.hpp"
+#include <thread>
+#include <memory>
+#include <chrono>
+
+class ParallelDFSearch::Worker {
+public:
+   ParallelDFSearch*    _owner;
+   const int            _id;
+   CPSolver::Ptr        _cp;
+   Trailer::Ptr         _sm;
+   ParallelModel        _model;
+   WSDeque<SubTree>     _deque;
+   std::vector<Literal> _path;      // decisions from the root to the current node
+   long                 _opaqueAt;  // position (in _path) of the first unrecorded decision, -1 if none
+   SearchStatistics     _stats;
+   size_t               _nbVars;
+   size_t               _nbProp;
+   Worker(ParallelDFSearch* owner,int id)
+      : _owner(owner),_id(id),_opaqueAt(-1),_nbVars(0),_nbProp(0) {}
+   bool stop(const Limit& limit) { return _owner->stop(_stats,limit);}
+   bool splittable() const noexcept {
+      return _opaqueAt < 0 && (long)_path.size() < _owner->_splitDepth &&
+         _owner->_idle.load(std::memory_order_relaxed) > 0;
+   }
+   void explore(SubTree* t,const Limit& limit);
+   void dfs(const Limit& limit);
+   int donate(Branches& branches,int from,int to);
+};
+
+bool ParallelSearch::stop(SearchStatistics& ss,const Limit& limit)
+{
+   if (_stop.load(std::memory_order_relaxed))
+      return true;
+   ss.setSolutions(_solutions.load(std::memory_order_relaxed));
+   if (limit(ss)) {
+      _stop.store(true);
+      return true;
+   }
+   return false;
+}
+
+void ParallelSearch::solution(const ParallelModel& m,SearchStatistics& ss,const Limit& limit)
+{
+   std::lock_guard<std::mutex> guard(_lock);
+   if (_stop.load())
+      return;
+   auto obj = m.objective;
+   if (!obj || _incumbent.improve(obj->isMin() ? obj->value() : -(long long)obj->value())) {
+      _solutions.fetch_add(1);
+      if (m.onSolution)
+         m.onSolution();
+      stop(ss,limit);
+   }
+}
+
+void ParallelDFSearch::Worker::explore(SubTree* t,const Limit& limit)
+{
+   _path = t->_path;
+   _opaqueAt = -1;
+   _sm->saveState();
+   TRYFAIL
+      for(const auto& l : t->_path)
+         _cp->post(Factory::decision(_cp,l));
+      dfs(limit);
+   ONFAIL
+      _stats.incrFailures();
+   ENDFAIL
+   _sm->restoreState();
+}
+
+void ParallelDFSearch::Worker::dfs(const Limit& limit)
+{
+   Branches branches = _model.branching();
+   if (branches.size() == 0) {
+      _owner->solution(_model,_stats,limit);
+      if (_model.objective)
+         _model.objective->tighten();
+      return;
+   }
+   const int last = (int)branches.size() - 1;  // for proper counting of choices.
+   int nb = (int)branches.size();
+   for(int k = 0;k < nb && !stop(limit);k++) {
+      if (k < nb - 1 && splittable())
+         nb = donate(branches,k + 1,nb);
+      const auto& alt = *(branches.begin() + k);
+      const auto mark = _path.size();
+      _sm->saveState();
+      TRYFAIL
+         if (k != last)
+            _stats.incrNodes();
+         _cp->recordDecisions(&_path);
+         alt();
+         _cp->recordDecisions(nullptr);
+         if (_path.size() == mark) {          // nothing recorded: mark the decision opaque
+            if (_opaqueAt < 0)
+               _opaqueAt = mark;
+            _path.emplace_back();
+         }
+         dfs(limit);
+      ONFAIL
+         _cp->recordDecisions(nullptr);
+         _stats.incrFailures();
+      ENDFAIL
+      _path.resize(mark);
+      if (_opaqueAt >= (long)mark)
+         _opaqueAt = -1;
+      _sm->restoreState();
+   }
+   if (stop(limit))
+      throw StopException();
+}
+
+/**
+ * Probes the alternatives [from,to) of the current node to learn the decisions they post and
+ * pushes them on the deque. Failing alternatives are simply dropped.
+ * @return the bound on the alternatives left to explore locally (`from` on success, `to` if
+ * nothing was donated).
+ */
+int ParallelDFSearch::Worker::donate(Branches& branches,int from,int to)
+{
+   std::vector<SubTree*> gifts;
+   bool opaque = false;
+   for(int k = from;k < to && !opaque;k++) {
+      const auto& alt = *(branches.begin() + k);
+      const auto mark = _path.size();
+      _sm->saveState();
+      TRYFAIL
+         _cp->recordDecisions(&_path);
+         alt();
+         _cp->recordDecisions(nullptr);
+         if (_path.size() > mark)
+            gifts.push_back(new SubTree {_path});
+         else opaque = true;
+      ONFAIL
+         _cp->recordDecisions(nullptr);
+         _stats.incrFailures();
+      ENDFAIL
+      _path.resize(mark);
+      _sm->restoreState();
+   }
+   if (opaque || _deque.size() + (long)gifts.size() > _deque.capacity()) {
+      for(auto t : gifts)
+         delete t;
+      return to;
+   }
+   _owner->_pending.fetch_add(gifts.size());
+   for(auto i = gifts.rbegin();i != gifts.rend();i++)  // the first sibling ends up at the bottom
+      _deque.push(*i);
+   _owner->_work.notify_all();
+   return from;
+}
+
+ParallelDFSearch::ParallelDFSearch(ModelBuilder builder,int nbWorkers,int splitDepth)
+   : _builder(builder),
+     _nbWorkers(nbWorkers < 1 ? 1 : nbWorkers),
+     _splitDepth(splitDepth),
+     _pending(0),_idle(0)
+{}
+
+ParallelDFSearch::~ParallelDFSearch()
+{
+   for(auto w : _workers)
+      delete w;
+}
+
+SubTree* ParallelDFSearch::steal(Worker* w)
+{
+   for(int i = 1;i < _nbWorkers;i++) {
+      SubTree* t = _workers[(w->_id + i) % _nbWorkers]->_deque.steal();
+      if (t)
+         return t;
+   }
+   return nullptr;
+}
+
+void ParallelDFSearch::run(Worker* w,const Limit& limit)
+{
+   w->_cp = Factory::makeSolver();
+   w->_sm = w->_cp->getStateManager();
+   bool built;
+   TRYFAIL
+      w->_model = _builder(w->_cp,w->_id);
+      built = true;
+   ONFAIL
+      built = false;
+   ENDFAIL
+   if (!built) {   // the root is infeasible and every other worker will find out as well.
+      _stop.store(true);
+      w->_cp.dealloc();
+      return;
+   }
+   if (w->_model.objective)
+      w->_model.objective->share(&_incumbent);
+   w->_nbVars = w->_cp->getNbVars();
+   w->_nbProp = w->_cp->getNbProp();
+   w->_sm->enable();
+   bool idle = false;
+   try {
+      while (_pending.load() > 0 && !_stop.load(std::memory_order_relaxed)) {
+         std::unique_ptr<SubTree> t(w->_deque.pop());
+         if (!t)
+            t.reset(steal(w));
+         if (!t) {
+            if (!idle) {
+               idle = true;
+               _idle.fetch_add(1);
+            }
+            std::unique_lock<std::mutex> guard(_workLock);
+            _work.wait_for(guard,std::chrono::milliseconds(1));   // the timeout covers a missed signal and a stop
+            continue;
+         }
+         if (idle) {
+            idle = false;
+            _idle.fetch_sub(1);
+         }
+         w->explore(t.get(),limit);
+         if (_pending.fetch_sub(1) == 1)
+            _work.notify_all();
+      }
+   } catch(StopException& sx) {
+      w->_stats.setNotCompleted();
+   }
+   if (idle)
+      _idle.fetch_sub(1);
+   w->_stats.setPropagations(w->_cp->getPropagations());
+   w->_stats.setAvoidedWakeups(w->_cp->getAvoidedWakeups());
+   w->_cp.dealloc();
+}
+
+SearchStatistics ParallelDFSearch::solve(SearchStatistics& stats,Limit limit)
+{
+   _pending = 1;
+   _idle = 0;
+   _stop = false;
+   _solutions = 0;
+   for(int i = 0;i < _nbWorkers;i++)
+      _workers.push_back(new Worker(this,i));
+   _workers[0]->_deque.push(new SubTree());
+   std::vector<std::thread> threads;
+   for(auto w : _workers)
+      threads.emplace_back([this,w,&limit] { run(w,limit);});
+   for(auto& t : threads)
+      t.join();
+   stats.setIntVars(_workers[0]->_nbVars);
+   stats.setPropagators(_workers[0]->_nbProp);
+   for(auto w : _workers) {
+      while (SubTree* t = w->_deque.pop())
+         delete t;
+      stats.merge(w->_stats);
+      if (!w->_stats.getCompleted())
+         stats.setNotCompleted();
+      delete w;
+   }
+   _workers.clear();
+   stats.setSolutions(_solutions.load());
+   stats.setSolveTime();
+   return stats;
+}
+
+SearchStatistics ParallelDFSearch::solve(Limit limit)
+{
+   SearchStatistics stats;
+   solve(stats,limit);
+   return stats;
+}
+
+SearchStatistics ParallelDFSearch::solve()
+{
+   SearchStatistics stats;
+   solve(stats,[](const SearchStatistics& ss) { return false;});
+   return stats;
+}
+
+EPSearch::EPSearch(ModelBuilder builder,int nbWorkers)
+   : _builder(builder),
+     _nbWorkers(nbWorkers < 1 ? 1 : nbWorkers),
+     _next(0),
+     _ready(false),
+     _nbVars(0),_nbProp(0)
+{}
+
+/**
+ * Collects the consistent nodes reached `depth` decisions below the current node.
+ * @return true if some node was cut by the depth limit (so a deeper decomposition would differ).
+ */
+bool EPSearch::split(CPSolver::Ptr cp,const std::function<Branches(void)>& branching,
+                     std::vector<Literal>& path,int depth,SearchStatistics& stats)
+{
+   if (depth == 0) {
+      _subproblems.push_back(SubTree {path});
+      return true;
+   }
+   Branches branches = branching();
+   if (branches.size() == 0) {
+      _subproblems.push_back(SubTree {path});
+      return false;
+   }
+   auto sm = cp->getStateManager();
+   const auto first = _subproblems.size();
+   bool cut = false,opaque = false;
+   for(auto cur = branches.begin();cur != branches.end() && !opaque;cur++) {
+      const auto& alt = *cur;
+      const auto mark = path.size();
+      sm->saveState();
+      TRYFAIL
+         stats.incrNodes();
+         cp->recordDecisions(&path);
+         alt();
+         cp->recordDecisions(nullptr);
+         if (path.size() == mark)
+            opaque = true;
+         else if (split(cp,branching,path,depth - 1,stats))
+            cut = true;
+      ONFAIL
+         cp->recordDecisions(nullptr);
+         stats.incrFailures();
+      ENDFAIL
+      path.resize(mark);
+      sm->restoreState();
+   }
+   if (opaque) {   // this node cannot be described below, it is a subproblem on its own.
+      _subproblems.resize(first);
+      _subproblems.push_back(SubTree {path});
+      return false;
+   }
+   return cut;
+}
+
+size_t EPSearch::decompose(size_t target,SearchStatistics& stats,int maxDepth)
+{
+   _subproblems.clear();
+   _ready = true;
+   CPSolver::Ptr cp = Factory::makeSolver();
+   ParallelModel model;
+   bool built;
+   TRYFAIL
+      model = _builder(cp,0);
+      built = true;
+   ONFAIL
+      built = false;
+   ENDFAIL
+   if (built) {
+      stats.setIntVars(cp->getNbVars());
+      stats.setPropagators(cp->getNbProp());
+      auto sm = cp->getStateManager();
+      sm->enable();
+      std::vector<Literal> path;
+      for(int depth = 1;depth <= maxDepth;depth++) {
+         _subproblems.clear();
+         bool cut;
+         sm->saveState();
+         TRYFAIL
+            cut = split(cp,model.branching,path,depth,stats);
+         ONFAIL
+            cut = false;
+         ENDFAIL
+         sm->restoreState();
+         if (!cut || _subproblems.size() >= target)
+            break;
+      }
+   }
+   cp.dealloc();
+   return _subproblems.size();
+}
+
+void EPSearch::save(std::ostream& os) const
+{
+   for(const auto& t : _subproblems) {
+      os << t._path.size();
+      for(const auto& l : t._path)
+         os << ' ' << l._var << ' ' << (int)l._rel << ' ' << l._val;
+      os << '\n';
+   }
+}
+
+bool EPSearch::load(std::istream& is)
+{
+   _subproblems.clear();
+   size_t sz;
+   while (is >> sz) {
+      SubTree t;
+      for(size_t i = 0;i < sz;i++) {
+         int var,rel,val;
+         if (!(is >> var >> rel >> val) || var < 0 || rel < Literal::EQ || rel > Literal::GEQ)
+            return false;
+         t._path.emplace_back(var,(Literal::Rel)rel,val);
+      }
+      _subproblems.emplace_back(std::move(t));
+   }
+   _ready = is.eof();
+   return _ready;
+}
+
+void EPSearch::run(int id,SearchStatistics& stats,const Limit& limit)
+{
+   CPSolver::Ptr cp = Factory::makeSolver();
+   ParallelModel model;
+   bool built;
+   TRYFAIL
+      model = _builder(cp,id);
+      built = true;
+   ONFAIL
+      built = false;
+   ENDFAIL
+   if (built) {
+      if (id == 0) {
+         _nbVars = cp->getNbVars();
+         _nbProp = cp->getNbProp();
+      }
+      if (model.objective)
+         model.objective->share(&_incumbent);
+      DFSearch search(cp,std::function<Branches(void)>(model.branching));
+      search.onSolution([this,&model,&stats,&limit] { solution(model,stats,limit);});
+      if (model.objective) {
+         auto obj = model.objective;
+         search.onSolution([obj] { obj->tighten();});
+      }
+      Limit shared = [this,&limit](const SearchStatistics& ss) {
+         SearchStatistics global(ss);
+         return stop(global,limit);
+      };
+      for(size_t i = _next.fetch_add(1);i < _subproblems.size();i = _next.fetch_add(1)) {
+         if (_stop.load(std::memory_order_relaxed)) {
+            stats.setNotCompleted();
+            break;
+         }
+         const auto& path = _subproblems[i]._path;
+         auto ss = search.solveSubjectTo(shared,[cp,&path] {
+            for(const auto& l : path)
+               cp->post(Factory::decision(cp,l));
+         });
+         stats.merge(ss);
+         if (!ss.getCompleted())
+            stats.setNotCompleted();
+      }
+      stats.setPropagations(cp->getPropagations());
+      stats.setAvoidedWakeups(cp->getAvoidedWakeups());
+   } else _stop.store(true);   // the root is infeasible
+   cp.dealloc();
+}
+
+SearchStatistics EPSearch::solve(SearchStatistics& stats,Limit limit)
+{
+   if (!_ready)
+      decompose(30 * _nbWorkers,stats);
+   _next = 0;
+   _stop = false;
+   _solutions = 0;
+   std::vector<SearchStatistics> ws(_nbWorkers);
+   std::vector<std::thread> threads;
+   for(int i = 0;i < _nbWorkers;i++)
+      threads.emplace_back([this,i,&ws,&limit] { run(i,ws[i],limit);});
+   for(auto& t : threads)
+      t.join();
+   stats.setIntVars(_nbVars);
+   stats.setPropagators(_nbProp);
+   for(auto& w : ws) {
+      stats.merge(w);
+      if (!w.getCompleted())
+         stats.setNotCompleted();
+   }
+   stats.setSolutions(_solutions.load());
+   stats.setSolveTime();
+   return stats;
+}
+
+SearchStatistics EPSearch::solve(Limit limit)
+{
+   SearchStatistics stats;
+   solve(stats,limit);
+   return stats;
+}
+
+SearchStatistics EPSearch::solve()
+{
+   SearchStatistics stats;
+   solve(stats,[](const SearchStatistics& ss) { return false;});
+   return stats;
+}
+
+PortfolioSearch::PortfolioSearch(ModelBuilder builder,int nbWorkers)
+   : _builder(builder),
+     _nbWorkers(nbWorkers < 1 ? 1 : nbWorkers),
+     _proved(false),
+     _nbVars(0),_nbProp(0)
+{}
+
+void PortfolioSearch::run(int id,SearchStatistics& stats,const Limit& limit)
+{
+   CPSolver::Ptr cp = Factory::makeSolver();
+   ParallelModel model;
+   bool built;
+   TRYFAIL
+      model = _builder(cp,id);
+      built = true;
+   ONFAIL
+      built = false;
+   ENDFAIL
+   if (built) {
+      if (id == 0) {
+         _nbVars = cp->getNbVars();
+         _nbProp = cp->getNbProp();
+      }
+      if (model.objective)
+         model.objective->share(&_incumbent);
+      Limit shared = [this,&limit](const SearchStatistics& ss) {
+         SearchStatistics global(ss);
+         return stop(global,limit);
+      };
+      if (model.restarts) {
+         RestartSearch search(cp,std::function<Branches(void)>(model.branching),model.restarts);
+         search.onSolution([this,&model,&stats,&limit] { solution(model,stats,limit);});
+         if (model.objective)
+            search.optimize(model.objective,stats,shared);   // tightens the objective on every solution
+         else
+            search.solve(stats,shared);
+      } else {
+         DFSearch search(cp,std::function<Branches(void)>(model.branching));
+         search.onSolution([this,&model,&stats,&limit] { solution(model,stats,limit);});
+         if (model.objective) {
+            auto obj = model.objective;
+            search.onSolution([obj] { obj->tighten();});
+         }
+         search.solve(stats,shared);
+      }
+   }
+   if (stats.getCompleted()) {   // this worker settled the question for everyone
+      _proved.store(true);
+      _stop.store(true);
+   }
+   cp.dealloc();
+}
+
+SearchStatistics PortfolioSearch::solve(SearchStatistics& stats,Limit limit)
+{
+   _stop = false;
+   _proved = false;
+   _solutions = 0;
+   std::vector<SearchStatistics> ws(_nbWorkers);
+   std::vector<std::thread> threads;
+   for(int i = 0;i < _nbWorkers;i++)
+      threads.emplace_back([this,i,&ws,&limit] { run(i,ws[i],limit);});
+   for(auto& t : threads)
+      t.join();
+   stats.setIntVars(_nbVars);
+   stats.setPropagators(_nbProp);
+   for(const auto& w : ws)
+      stats.merge(w);
+   if (!_proved.load())
+      stats.setNotCompleted();
+   stats.setSolutions(_solutions.load());
+   stats.setSolveTime();
+   return stats;
+}
+
+SearchStatistics PortfolioSearch::solve(Limit limit)
+{
+   SearchStatistics stats;
+   solve(stats,limit);
+   return stats;
+}
+
+SearchStatistics PortfolioSearch::solve()
+{
+   SearchStatistics stats;
+   solve(stats,[](const SearchStatistics& ss) { return false;});
+   return stats;
+}
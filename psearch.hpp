@@ -0,0 +1,288 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __PSEARCH_H
+#define __PSEARCH_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "search.hpp"
+#include "literal.hpp"
+
+/**
+ * @brief Bounded lock-free work-stealing deque (Chase & Lev).
+ *
+ * The owner pushes and pops at the bottom (LIFO, so it keeps diving depth-first) while
+ * other threads steal from the top, i.e., the oldest and typically largest pieces of work.
+ * Stealing may spuriously return `nullptr` when it races with another thief or with the owner.
+ * @param `T` the type of the items. The deque only holds pointers to them.
+ */
+template <class T> class WSDeque {
+   std::atomic<long> _top;
+   std::atomic<long> _bottom;
+   std::atomic<T*>*  _buf;
+   const long        _mask;
+public:
+   /**
+    * @param logCap the capacity of the deque is \f$2^{logCap}\f$
+    */
+   WSDeque(int logCap = 12) : _top(0),_bottom(0),_mask((1L << logCap) - 1) {
+      _buf = new std::atomic<T*>[_mask + 1];
+   }
+   ~WSDeque() { delete[] _buf;}
+   long capacity() const noexcept { return _mask + 1;}
+   /**
+    * Approximate number of items (exact when called by the owner with no concurrent thief).
+    */
+   long size() const noexcept {
+      long sz = _bottom.load(std::memory_order_relaxed) - _top.load(std::memory_order_relaxed);
+      return sz < 0 ? 0 : sz;
+   }
+   /**
+    * Owner only. Adds an item at the bottom.
+    * @return false if the deque is full (the item was not added).
+    */
+   bool push(T* v) noexcept {
+      long b = _bottom.load(std::memory_order_relaxed);
+      long t = _top.load(std::memory_order_acquire);
+      if (b - t > _mask)
+         return false;
+      _buf[b & _mask].store(v,std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      _bottom.store(b + 1,std::memory_order_relaxed);
+      return true;
+   }
+   /**
+    * Owner only. Removes the most recently pushed item.
+    * @return the item or `nullptr` if the deque is empty.
+    */
+   T* pop() noexcept {
+      long b = _bottom.load(std::memory_order_relaxed) - 1;
+      _bottom.store(b,std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      long t = _top.load(std::memory_order_relaxed);
+      if (t <= b) {
+         T* v = _buf[b & _mask].load(std::memory_order_relaxed);
+         if (t == b) {
+            if (!_top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed))
+               v = nullptr;
+            _bottom.store(b + 1,std::memory_order_relaxed);
+         }
+         return v;
+      } else {
+         _bottom.store(b + 1,std::memory_order_relaxed);
+         return nullptr;
+      }
+   }
+   /**
+    * Any thread. Removes the oldest item.
+    * @return the item or `nullptr` if the deque is empty or the steal lost a race.
+    */
+   T* steal() noexcept {
+      long t = _top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      long b = _bottom.load(std::memory_order_acquire);
+      if (t < b) {
+         T* v = _buf[t & _mask].load(std::memory_order_relaxed);
+         if (!_top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed))
+            return nullptr;
+         return v;
+      }
+      return nullptr;
+   }
+};
+
+/**
+ * @brief A subproblem of a parallel search: the decisions leading from the root to its top node.
+ */
+struct SubTree {
+   std::vector<Literal> _path;
+};
+
+/**
+ * @brief What a model builder returns for the solver it just populated.
+ */
+struct ParallelModel {
+   std::function<Branches(void)> branching;   //!< the branching heuristic
+   Objective::Ptr                objective;   //!< the objective to optimize (nullptr to solve)
+   std::function<void(void)>     onSolution;  //!< called (serialized) on every reported solution
+   Restart::Schedule             restarts;    //!< when set, a portfolio worker runs a RestartSearch on this schedule
+};
+
+/**
+ * A model builder populates the solver of one worker (it runs in the worker thread).
+ * Its second argument is the index of the worker.
+ */
+typedef std::function<ParallelModel(CPSolver::Ptr,int)> ModelBuilder;
+
+/**
+ * @brief State shared by the workers of a parallel search: the stop flag, the number of
+ * reported solutions and (when optimizing) the incumbent.
+ */
+class ParallelSearch {
+protected:
+   std::atomic<bool>      _stop;
+   std::atomic<int>       _solutions;
+   Incumbent              _incumbent;
+   std::mutex             _lock;      // serializes the reporting of solutions
+   ParallelSearch() : _stop(false),_solutions(0) {}
+   /**
+    * Evaluates the limit on the statistics of a worker, once patched with the global solution count.
+    * Raises the stop flag when the limit is reached.
+    * @return true if and only if the search must stop.
+    */
+   bool stop(SearchStatistics& ss,const Limit& limit);
+   /**
+    * Reports the solution a worker just found unless the search is stopping or, when optimizing,
+    * the solution does not improve on the incumbent. It is up to the caller to tighten the objective.
+    */
+   void solution(const ParallelModel& m,SearchStatistics& ss,const Limit& limit);
+};
+
+/**
+ * @brief Work-stealing parallel depth-first search.
+ *
+ * Every worker thread owns a private CPSolver (hence its own Trailer and Storage) populated by
+ * the model builder. Subtrees travel between workers as the list of decisions (Literal) that
+ * lead to them and are replayed with `Factory::decision`. A busy worker splits its current node
+ * when some other worker is idle: the remaining alternatives are pushed, as subtrees, on its
+ * deque where they can be stolen.
+ *
+ * Alternatives are expected to post a single decision through `CPSolver::post(ConstraintDesc::Ptr)`
+ * (like `x == v`, `x != v`, `x <= v` and `x >= v` do). Below an alternative that posts nothing recordable the worker
+ * never splits and simply keeps the work to itself.
+ *
+ * The model builder must create the same variables in the same order in every worker.
+ * The solution count, the stop flag and (when optimizing) the incumbent are shared by all the workers.
+ * The limit is evaluated by each worker on its own statistics, but with the global solution count.
+ */
+class ParallelDFSearch : public ParallelSearch {
+   class Worker;
+   ModelBuilder           _builder;
+   const int              _nbWorkers;
+   const int              _splitDepth;
+   std::vector<Worker*>   _workers;
+   std::atomic<long>      _pending;   // subtrees not fully explored yet
+   std::atomic<int>       _idle;      // workers looking for work
+   std::mutex             _workLock;
+   std::condition_variable _work;     // signaled when subtrees are donated and when the last one is done
+   void run(Worker* w,const Limit& limit);
+   SubTree* steal(Worker* w);
+public:
+   /**
+    * @param builder the model builder
+    * @param nbWorkers the number of threads
+    * @param splitDepth nodes with more decisions than this on their path are never split
+    */
+   ParallelDFSearch(ModelBuilder builder,int nbWorkers,int splitDepth = 32);
+   ~ParallelDFSearch();
+   SearchStatistics solve(SearchStatistics& stat,Limit limit);
+   SearchStatistics solve(Limit limit);
+   SearchStatistics solve();
+};
+
+/**
+ * @brief Embarrassingly parallel search (EPS).
+ *
+ * A master solver runs the branching of the model down to a fixed depth and collects the
+ * consistent nodes it reaches (each one is the list of decisions leading to it). The depth
+ * is increased until there are enough subproblems. Workers (one solver per thread) then pull
+ * subproblems from the list and solve each of them with `DFSearch::solveSubjectTo`.
+ * There is no communication between workers beyond the solution count, the stop flag and the incumbent.
+ *
+ * The subproblem list can be saved and loaded, so that a decomposition can be replayed (with a
+ * single worker, the replay is fully deterministic). Like for ParallelDFSearch, the model builder
+ * must create the same variables in the same order every time and alternatives are expected to
+ * post their decision through `CPSolver::post(ConstraintDesc::Ptr)`. A node whose alternatives
+ * post nothing recordable is not decomposed any further.
+ */
+class EPSearch : public ParallelSearch {
+   ModelBuilder           _builder;
+   const int              _nbWorkers;
+   std::vector<SubTree>   _subproblems;
+   std::atomic<size_t>    _next;      // next subproblem to hand out
+   bool                   _ready;     // the subproblems were computed or loaded
+   size_t                 _nbVars;    // the size of the model of worker 0
+   size_t                 _nbProp;
+   bool split(CPSolver::Ptr cp,const std::function<Branches(void)>& branching,
+              std::vector<Literal>& path,int depth,SearchStatistics& stats);
+   void run(int id,SearchStatistics& stats,const Limit& limit);
+public:
+   /**
+    * @param builder the model builder (the master solver is built with index 0)
+    * @param nbWorkers the number of threads
+    */
+   EPSearch(ModelBuilder builder,int nbWorkers);
+   /**
+    * Decomposes the problem with a master solver.
+    * @param target the minimum number of subproblems wanted
+    * @param stats receives the nodes and failures of the decomposition
+    * @param maxDepth the decomposition never goes deeper than this
+    * @return the number of subproblems (0 when the root is inconsistent)
+    */
+   size_t decompose(size_t target,SearchStatistics& stats,int maxDepth = 64);
+   const std::vector<SubTree>& subproblems() const noexcept { return _subproblems;}
+   /**
+    * Writes the subproblems, one per line: the number of decisions followed by
+    * a `variable relation value` triplet per decision.
+    */
+   void save(std::ostream& os) const;
+   /**
+    * Replaces the subproblems with those read from a stream produced by `save`.
+    * @return false if the stream is malformed
+    */
+   bool load(std::istream& is);
+   /**
+    * Solves all the subproblems (decomposing first with the default target of 30 subproblems
+    * per worker if `decompose` or `load` was not called).
+    */
+   SearchStatistics solve(SearchStatistics& stat,Limit limit);
+   SearchStatistics solve(Limit limit);
+   SearchStatistics solve();
+};
+
+/**
+ * @brief Portfolio of independent depth-first searches.
+ *
+ * Every worker builds its own solver and explores the whole search space with a `DFSearch`, or
+ * with a `RestartSearch` when its model comes with a restart schedule.
+ * The builder receives the index of the worker and is expected to return a different
+ * branching for each index (variable/value selection, randomization, ...). Workers share the
+ * solution count and the incumbent, so each one prunes with the best objective found by any of them.
+ * The first worker to exhaust its search space proves optimality (or unsatisfiability) and
+ * cancels the others. Without objective, the workers may report the same solution: a portfolio
+ * is meant to find one solution, not to enumerate them.
+ */
+class PortfolioSearch : public ParallelSearch {
+   ModelBuilder           _builder;
+   const int              _nbWorkers;
+   std::atomic<bool>      _proved;    // some worker completed its search
+   size_t                 _nbVars;    // the size of the model of worker 0
+   size_t                 _nbProp;
+   void run(int id,SearchStatistics& stats,const Limit& limit);
+public:
+   /**
+    * @param builder the model builder (called with the index of the worker)
+    * @param nbWorkers the number of threads
+    */
+   PortfolioSearch(ModelBuilder builder,int nbWorkers);
+   SearchStatistics solve(SearchStatistics& stat,Limit limit);
+   SearchStatistics solve(Limit limit);
+   SearchStatistics solve();
+};
+
+#endif
@@ -64,6 +64,7 @@ public:
       : Constraint(x[0]->getSolver()),_A(A),
         _x(x.size(),Factory::alloci(x[0]->getStore()))
    {
+      setPriority(QUADRATIC);
       int i  = 0;
       for(auto& xi : x)
          _x[i++] = xi;
@@ -0,0 +1,65 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "scores.hpp"
+#include "solver.hpp"
+#include "intvar.hpp"
+#include <cmath>
+
+Scores::Scores(CPSolver* cp,double decay)
+   : _cp(cp),_round(0),_inc(1.0),_decay(decay)
+{
+   if (cp->getNbVars() > 0)
+      ensure((int)cp->getNbVars() - 1);
+}
+
+void Scores::ensure(int id)
+{
+   if (id >= (int)_stamp.size()) {
+      _activity.resize(id + 1,0.0);
+      _stamp.resize(id + 1,0);
+      _impact.resize(id + 1,0.0);
+      _nbImpacts.resize(id + 1,0);
+   }
+}
+
+void Scores::startFixpoint()
+{
+   ++_round;
+   _inc /= _decay;
+   if (_inc > 1e100) {   // rescales before the scores overflow
+      for(double& a : _activity)
+         a *= 1e-100;
+      _inc *= 1e-100;
+   }
+}
+
+double Scores::logSpace() const
+{
+   double s = 0;
+   for(std::size_t i = 0;i < _cp->getNbVars();i++)
+      s += std::log((double)static_cast<var<int>*>(_cp->varAt((int)i).get())->size());
+   return s;
+}
+
+void Scores::decided(int id,double before,bool failed)
+{
+   if (id < 0)
+      return;
+   ensure(id);
+   const double i = failed ? 1.0 : 1.0 - std::exp(logSpace() - before);
+   const unsigned n = ++_nbImpacts[id];
+   _impact[id] += (i - _impact[id]) / n;
+}
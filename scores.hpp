@@ -0,0 +1,79 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __SCORES_H
+#define __SCORES_H
+
+#include <vector>
+
+class CPSolver;
+
+/**
+ * @brief Activity and impact of the variables of a solver (see CPSolver::setScoring), the statistics
+ * behind the activity-based and impact-based branchings.
+ *
+ * The activity of a variable counts the fixpoints that reduced its domain and decays over time
+ * (the increment grows by 1/decay with every fixpoint rather than every score shrinking).
+ * The impact of a variable is the average reduction of the search space by the decisions on it:
+ * \f$1 - S_{after} / S_{before}\f$ where \f$S\f$ is the product of the sizes of the domains.
+ * A decision that fails has an impact of 1.
+ */
+class Scores {
+   CPSolver*             _cp;
+   std::vector<double>   _activity;
+   std::vector<unsigned> _stamp;      // the fixpoint that last reduced the domain
+   std::vector<double>   _impact;
+   std::vector<unsigned> _nbImpacts;  // decisions the impact averages
+   unsigned              _round;
+   double                _inc;
+   double                _decay;
+   void ensure(int id);
+public:
+   Scores(CPSolver* cp,double decay = 0.99);
+   /**
+    * Called at the start of every fixpoint.
+    */
+   void startFixpoint();
+   /**
+    * Called whenever the domain of the variable `id` is reduced.
+    */
+   void touch(int id) {
+      if (id < 0)
+         return;
+      if (id >= (int)_stamp.size())
+         ensure(id);
+      if (_stamp[id] != _round) {
+         _stamp[id] = _round;
+         _activity[id] += _inc;
+      }
+   }
+   /**
+    * @return the log of the size of the search space (the sum of the logs of the sizes of the domains)
+    */
+   double logSpace() const;
+   /**
+    * Records the impact of a decision on the variable `id`.
+    * @param before the log of the size of the search space before the decision (see logSpace)
+    * @param failed true if the decision failed
+    */
+   void decided(int id,double before,bool failed);
+   double activity(int id) const { return id >= 0 && id < (int)_activity.size() ? _activity[id] : 0.0;}
+   /**
+    * @return the impact of the variable `id` (0 until a decision is made on it)
+    */
+   double impact(int id) const   { return id >= 0 && id < (int)_impact.size() ? _impact[id] : 0.0;}
+};
+
+#endif
@@ -13,19 +13,20 @@
  * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
  */
 
+#include <cstdio>
+#include <cmath>
 #include "search.hpp"
 #include "intvar.hpp"
 #include "constraint.hpp"
 #include "tracer.hpp"
 
-class StopException {};
-
 typedef std::function<void(void)> VVFun;
 
 SearchStatistics DFSearch::solve(SearchStatistics& stats,Limit limit)
 {
     stats.setIntVars(_cp->getNbVars());
     stats.setPropagators(_cp->getNbProp());
+    _path.clear();
     _sm->withNewState(VVFun([this,&stats,&limit]() {
                                try {
                                   dfs(stats,limit);
@@ -35,6 +36,7 @@ SearchStatistics DFSearch::solve(SearchStatistics& stats,Limit limit)
                             }));
     stats.setSolveTime();
     stats.setPropagations(_cp->getPropagations());
+    stats.setAvoidedWakeups(_cp->getAvoidedWakeups());
     return stats;
 }
 
@@ -55,11 +57,18 @@ SearchStatistics DFSearch::solve()
 SearchStatistics DFSearch::solveSubjectTo(Limit limit,std::function<void(void)> subjectTo)
 {
     SearchStatistics stats;
+    _path.clear();
     _sm->withNewState(VVFun([this,&stats,&limit,&subjectTo]() {
                                try {
-                                  subjectTo();
-                                  dfs(stats,limit);
-                               } catch(StopException& sx) {}
+                                  TRYFAIL
+                                     subjectTo();
+                                     dfs(stats,limit);
+                                  ONFAIL
+                                     stats.incrFailures();
+                                  ENDFAIL
+                               } catch(StopException& sx) {
+                                  stats.setNotCompleted();
+                               }
                             }));
     return stats;
 }
@@ -91,10 +100,21 @@ SearchStatistics DFSearch::optimize(Objective::Ptr obj)
 SearchStatistics DFSearch::optimizeSubjectTo(Objective::Ptr obj,Limit limit,std::function<void(void)> subjectTo)
 {
    SearchStatistics stats;
-   _sm->withNewState(VVFun([this,&stats,obj,&limit,&subjectTo]() {
+   if (_objective.get() != obj.get()) {   // tightens once per solution, however many times it is called
+      _objective = obj;
+      onSolution([obj] { obj->tighten();});
+   }
+   _sm->withNewState(VVFun([this,&stats,&limit,&subjectTo]() {
                               try {
-                                 subjectTo();
-                                 stats = optimize(obj,limit);
+                                 bool consistent = true;
+                                 TRYFAIL
+                                    subjectTo();
+                                 ONFAIL
+                                    consistent = false;
+                                    stats.incrFailures();
+                                 ENDFAIL
+                                 if (consistent)
+                                    solve(stats,limit);
                               } catch(StopException& sx) {}
                            }));
    return stats;
@@ -117,23 +137,41 @@ void DFSearch::dfs(SearchStatistics& stats,const Limit& limit)
        for(auto cur = branches.begin(); cur != branches.end() and !limit(stats); cur++)
        {
           const auto& alt = *cur;
+          const auto mark = _path.size();
           _sm->saveState();
           try {
              TRYFAIL {
                 if (cur != last)
                    stats.incrNodes();
-                alt();
+                if (_track) {
+                   _cp->recordDecisions(&_path);
+                   alt();
+                   _cp->recordDecisions(nullptr);
+                   if (_path.size() != mark + 1) {   // not a single decision: leave an undefined literal
+                      _path.resize(mark);
+                      _path.emplace_back();
+                   }
+                } else alt();
                 dfs(stats, limit);
              } ONFAIL {
+                if (_track)
+                   _cp->recordDecisions(nullptr);
                 stats.incrFailures();
                 notifyFailure();
              }
              ENDFAIL {
+                _path.resize(mark);
                 _sm->restoreState();
              }
+          } catch(StopException& sx) {   // keeps the path to the node where the search stopped
+             _sm->restoreState();
+             throw;
           } catch(...) {  // the C++ exception catching is to stay compatible with python interfaces. 0-cost for C++
+             if (_track)
+                _cp->recordDecisions(nullptr);
              stats.incrFailures();
              notifyFailure();
+             _path.resize(mark);
              _sm->restoreState();
           }
        }
@@ -143,11 +181,134 @@ void DFSearch::dfs(SearchStatistics& stats,const Limit& limit)
     }
 }
 
+Restart::Schedule Restart::luby(long scale)
+{
+   return [scale](int run) {
+      long i = run + 1;            // the Luby sequence is defined from 1
+      long k = 1;
+      while (true) {
+         while ((1L << k) - 1 < i)   // the smallest k such that i <= 2^k - 1
+            k += 1;
+         if (i == (1L << k) - 1)
+            return scale * (1L << (k - 1));
+         i -= (1L << (k - 1)) - 1;
+         k = 1;
+      }
+   };
+}
+
+Restart::Schedule Restart::geometric(long base,double factor)
+{
+   return [base,factor](int run) {
+      return (long)(base * std::pow(factor,run));
+   };
+}
+
+/**
+ * Posts, at the root, the nogoods of the branch on which the last run stopped.
+ * @return false if a nogood makes the root inconsistent (the search is then complete)
+ */
+bool RestartSearch::learn()
+{
+   std::vector<var<int>::Ptr> x;
+   std::vector<int>           v;
+   bool ok = true;
+   TRYFAIL
+      for(const Literal& l : _dfs.path()) {
+         if (l._var < 0 || l._rel == Literal::LEQ || l._rel == Literal::GEQ)   // nogoods only hold equalities
+            break;
+         var<int>::Ptr xl = static_cast<var<int>*>(_cp->varAt(l._var).get());
+         if (l._rel == Literal::NEQ) {   // the subtree below x == v was refuted
+            x.push_back(xl);
+            v.push_back(l._val);
+            _cp->post(Factory::nogood(x,v));
+            _nbNogoods += 1;
+            x.pop_back();
+            v.pop_back();
+         } else {
+            x.push_back(xl);
+            v.push_back(l._val);
+         }
+      }
+   ONFAIL
+      ok = false;
+   ENDFAIL
+   return ok;
+}
+
+SearchStatistics& RestartSearch::run(SearchStatistics& stats,const Limit& limit)
+{
+   stats.setIntVars(_cp->getNbVars());
+   stats.setPropagators(_cp->getNbProp());
+   _dfs.trackPath(_nogoods);
+   for(int r = 0;;r++) {
+      const long cutoff = _schedule(r);
+      SearchStatistics rs;
+      _dfs.solve(rs,[&stats,&limit,cutoff](const SearchStatistics& ss) {
+                       SearchStatistics all = stats;
+                       all.merge(ss);
+                       all.setSolutions(stats.numberOfSolutions() + ss.numberOfSolutions());
+                       return limit(all) || ss.numberOfFailures() >= cutoff;
+                    });
+      stats.merge(rs);
+      stats.setSolutions(stats.numberOfSolutions() + rs.numberOfSolutions());
+      if (rs.getCompleted())
+         break;
+      if (limit(stats)) {
+         stats.setNotCompleted();
+         break;
+      }
+      _nbRestarts += 1;
+      if (_nogoods && !learn())
+         break;
+   }
+   stats.setSolveTime();
+   stats.setPropagations(_cp->getPropagations());
+   stats.setAvoidedWakeups(_cp->getAvoidedWakeups());
+   return stats;
+}
+
+SearchStatistics RestartSearch::solve(SearchStatistics& stats,Limit limit)
+{
+   return run(stats,[limit](const SearchStatistics& ss) { return ss.numberOfSolutions() >= 1 || limit(ss);});
+}
+
+SearchStatistics RestartSearch::solve(Limit limit)
+{
+   SearchStatistics stats;
+   return solve(stats,limit);
+}
+
+SearchStatistics RestartSearch::solve()
+{
+   SearchStatistics stats;
+   return solve(stats,[](const SearchStatistics& ss) { return false;});
+}
+
+SearchStatistics RestartSearch::optimize(Objective::Ptr obj,SearchStatistics& stats,Limit limit)
+{
+   _dfs.onSolution([obj] { obj->tighten();});
+   return run(stats,limit);
+}
+
+SearchStatistics RestartSearch::optimize(Objective::Ptr obj,Limit limit)
+{
+   SearchStatistics stats;
+   return optimize(obj,stats,limit);
+}
+
+SearchStatistics RestartSearch::optimize(Objective::Ptr obj)
+{
+   return optimize(obj,[](const SearchStatistics& ss) { return false;});
+}
+
 SearchStatistics BFSearch::solve(SearchStatistics& stats,Limit limit)
 {
     stats.setIntVars(_cp->getNbVars());
     stats.setPropagators(_cp->getNbProp());
     _cp->startSearch();
+    if (!_spillName.empty())
+       _spill.open(_spillName,std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
     Trailer::Ptr trail = _sm;
     trail->withNewState(VVFun([this,&stats,&limit]() {
                                try {
@@ -156,8 +317,14 @@ SearchStatistics BFSearch::solve(SearchStatistics& stats,Limit limit)
                                   stats.setNotCompleted();
                                }
                             }));
+    if (_spill.is_open()) {
+       _spill.close();
+       std::remove(_spillName.c_str());
+    }
+    _before = _root = nullptr;
     stats.setSolveTime();
     stats.setPropagations(_cp->getPropagations());
+    stats.setAvoidedWakeups(_cp->getAvoidedWakeups());
     return stats;
 }
 
@@ -203,10 +370,97 @@ SearchStatistics BFSearch::optimize(Objective::Ptr obj)
    return optimize(obj,[](const SearchStatistics& ss) { return false;});
 }
 
+void BFSearch::sample(std::size_t frontierSize)
+{
+   const CommandMemory& m = CommandMemory::current();
+   if (_fstats.inMemory > _fstats.maxInMemory)
+      _fstats.maxInMemory = _fstats.inMemory;
+   _fstats.maxPaths    = std::max(_fstats.maxPaths,m.maxPaths);
+   _fstats.maxCommands = std::max(_fstats.maxCommands,m.maxNodes);
+   std::size_t bytes = frontierSize * sizeof(BFSNode) + _fstats.inMemory * sizeof(Checkpoint) + m.bytes();
+   if (bytes > _fstats.maxBytes)
+      _fstats.maxBytes = bytes;
+}
+
+long BFSearch::spill(Checkpoint& node)
+{
+   std::vector<Literal> path;
+   if (!_spill.is_open() || !node.decisions(*_root,path))
+      return -1;
+   _spill.seekp(0,std::ios::end);
+   long at = (long)_spill.tellp();
+   _spill << path.size();      // one field at a time, as EPSearch::save
+   for(const auto& l : path)
+      _spill << ' ' << l._var << ' ' << (int)l._rel << ' ' << l._val;
+   _spill << '\n';
+   _fstats.spilled += 1;
+   _fstats.spillBytes += (long)_spill.tellp() - at;
+   return at;
+}
+
+bool BFSearch::reload(long offset)
+{
+   std::size_t nb = 0;
+   std::vector<Literal> path;
+   _spill.seekg(offset);
+   _spill >> nb;
+   for(std::size_t i = 0;i < nb;i++) {
+      int var,rel,val;
+      _spill >> var >> rel >> val;
+      path.emplace_back(var,(Literal::Rel)rel,val);
+   }
+   _fstats.reloaded += 1;
+   Tracer* tracer = _cp->tracer();
+   if (!tracer->restoreCheckpoint(_root,_cp))
+      return false;
+   tracer->pushNode();   // a fresh level to record the decisions on
+   for(const Literal& l : path)
+      _cp->post(Factory::decision(_cp,l),false);
+   _cp->fixpoint();
+   return true;
+}
+
+void BFSearch::dive(SearchStatistics& stats,const Limit& limit)
+{
+   Tracer* tracer = _cp->tracer();
+   Branches branches = _branching();
+   if (branches.size() == 0) {
+      stats.incrSolutions();
+      TRYFAIL {
+         notifySolution();
+      } ONFAIL {
+      } ENDFAIL {
+      }
+      return;
+   }
+   auto last = std::prev(branches.end());
+   for(auto cur = branches.begin(); cur != branches.end() and !limit(stats); cur++) {
+      const auto& alt = *cur;
+      auto before = tracer->captureCheckpoint();
+      TRYFAIL {
+         if (cur != last)
+            stats.incrNodes();
+         _cp->startBranching();
+         alt();
+         _cp->endBranching();
+         _fstats.dived += 1;
+         dive(stats,limit);
+      } ONFAIL {
+         _cp->endBranching();
+         stats.incrFailures();
+         notifyFailure();
+      }
+      ENDFAIL {
+         tracer->restoreCheckpoint(before,_cp);
+      }
+   }
+}
+
 void BFSearch::bfs(SearchStatistics& stats,const Limit& limit)
 {
    std::priority_queue<BFSNode, std::vector<BFSNode>, BFSNodeCompare> _frontier(BFSNodeCompare(_objective && _objective->isMin()));
    Tracer* tracer = _cp->tracer();
+   _root = tracer->captureCheckpoint();
    while (true) {
       Branches branches = _branching();
       if (branches.size() == 0) {
@@ -233,7 +487,22 @@ void BFSearch::bfs(SearchStatistics& stats,const Limit& limit)
                   if (cur != last)
                      stats.incrNodes();
                   alt();
-                  _frontier.push(BFSNode(tracer->captureCheckpoint(), _objective ? _objective->value() : 0, tracer->level()));
+                  const int value = _objective ? _objective->value() : 0;
+                  if (_budget <= 0 || _fstats.inMemory < _budget) {
+                     _frontier.push(BFSNode(tracer->captureCheckpoint(), value, tracer->level()));
+                     _fstats.inMemory += 1;
+                  } else {          // the frontier is full: spill the node or explore it now
+                     auto node = tracer->captureCheckpoint();
+                     long at = spill(*node);
+                     if (at >= 0)
+                        _frontier.push(BFSNode(at, value, tracer->level()));
+                     else {
+                        _cp->endBranching();
+                        dive(stats,limit);
+                        _cp->startBranching();
+                     }
+                  }
+                  sample(_frontier.size());
                } ONFAIL {
                   stats.incrFailures();
                   notifyFailure();
@@ -251,7 +520,7 @@ void BFSearch::bfs(SearchStatistics& stats,const Limit& limit)
       }
       BFSNode node;
       if (limit(stats)) {
-         if (_objective)
+         if (_objective && !_frontier.empty())
             _objective->setDual(_frontier.top()._objectiveValue);
          throw StopException();
       }
@@ -262,6 +531,8 @@ void BFSearch::bfs(SearchStatistics& stats,const Limit& limit)
          while (!_frontier.empty()) {
             node = _frontier.top();
             _frontier.pop();
+            if (node._checkpoint)
+               _fstats.inMemory -= 1;
             if (!_objective || _objective->betterThanPrimal(node._objectiveValue)) {
                feasibleNodeFound = true;
                break;
@@ -270,7 +541,8 @@ void BFSearch::bfs(SearchStatistics& stats,const Limit& limit)
          if (feasibleNodeFound) {
             try {
                TRYFAIL {
-                  successfulRestore = tracer->restoreCheckpoint(node._checkpoint,_cp);
+                  successfulRestore = node._checkpoint ? tracer->restoreCheckpoint(node._checkpoint,_cp)
+                                                       : reload(node._offset);
                } ONFAIL {
                   stats.incrFailures();
                   notifyFailure();
@@ -22,11 +22,18 @@
 #include <iostream>
 #include <iomanip>
 #include <queue>
+#include <fstream>
+#include <string>
+#include <random>
+#include <memory>
 
 #include "solver.hpp"
 #include "constraint.hpp"
 #include "RuntimeMonitor.hpp"
 #include "commandList.hpp"
+#include "scores.hpp"
+#include "varheap.hpp"
+#include "unboundvars.hpp"
 #include <utils.hpp>
 
 class Branches {
@@ -59,6 +66,7 @@ protected:
    int boolVariables;
    int propagators;
    unsigned long long propagations;
+   unsigned long long avoidedWakeups;
    RuntimeMonitor::HRClock _startTime;
    RuntimeMonitor::HRClock _initTime;
    RuntimeMonitor::HRClock _solveTime;
@@ -73,19 +81,34 @@ public:
       boolVariables(0),
       propagators(0),
       propagations(0),
+      avoidedWakeups(0),
       completed(true)
    {
       _initTime = _startTime = RuntimeMonitor::now();
    }
-   void incrFailures()  noexcept {failures += 1; extern int __nbf; __nbf = failures; }
-   void incrNodes()     noexcept {nodes += 1; extern int __nbn; __nbn = nodes;}
+   void incrFailures()  noexcept {failures += 1; extern __thread int __nbf; __nbf = failures; }
+   void incrNodes()     noexcept {nodes += 1; extern __thread int __nbn; __nbn = nodes;}
    void incrSolutions() noexcept {solutions += 1;}
+   void setSolutions(int count) noexcept { solutions = count;}
+   /**
+    * Accumulates the counters of a search that ran concurrently (e.g., another worker
+    * of a parallel search) into this one. Solutions are not added: they are tracked globally.
+    * Completion is not merged either as its meaning depends on how the work was shared.
+    * @param ss the statistics to absorb
+    */
+   void merge(const SearchStatistics& ss) noexcept {
+      nodes += ss.nodes;
+      failures += ss.failures;
+      propagations += ss.propagations;
+      avoidedWakeups += ss.avoidedWakeups;
+   }
    void setIntVars(int count) noexcept { intVariables = count;}
    void setBoolVars(int count) noexcept { boolVariables = count;}
    void setPropagators(int count) noexcept {propagators = count;}
    void setInitTime() noexcept { _initTime = RuntimeMonitor::now();}
    void setSolveTime() noexcept { _solveTime = RuntimeMonitor::now();}
    void setPropagations(unsigned long long p) noexcept {propagations = p;}
+   void setAvoidedWakeups(unsigned long long w) noexcept {avoidedWakeups = w;}
    void setNotCompleted() noexcept { completed = false;}
    bool getCompleted() noexcept {return completed;}
    int getSolutions() const noexcept {return solutions;}
@@ -103,6 +126,7 @@ public:
          << "Variables = " << ss.intVariables + ss.boolVariables << std::endl
          << "Constraints = " << ss.propagators << std::endl
          << "Propagations = " << ss.propagations << std::endl
+         << "Avoided Wakeups = " << ss.avoidedWakeups << std::endl
          << "Nodes = " << ss.nodes << std::endl
          << "Failures = " << ss.failures << std::endl;
    }
@@ -110,18 +134,33 @@ public:
 
 typedef std::function<bool(const SearchStatistics&)> Limit;
 
+/**
+ * Thrown (and caught by the search) to abandon the exploration once the limit is reached.
+ */
+class StopException {};
+
 class DFSearch {
    StateManager::Ptr                      _sm;
    CPSolver::Ptr                          _cp;
    std::function<Branches(void)>   _branching;
    std::vector<std::function<void(void)>>    _solutionListeners;
    std::vector<std::function<void(void)>>    _failureListeners;
+   bool                                      _track;
+   std::vector<Literal>                      _path;
+   Objective::Ptr                            _objective;   // the objective optimizeSubjectTo tightens
    void dfs(SearchStatistics& stats,const Limit& limit);
 public:
    DFSearch(CPSolver::Ptr cp,std::function<Branches(void)>&& b)
-      : _sm(cp->getStateManager()),_cp(cp),_branching(std::move(b)) {
+      : _sm(cp->getStateManager()),_cp(cp),_branching(std::move(b)),_track(false) {
       _sm->enable();
    }
+   /**
+    * Records the decisions (see CPSolver::recordDecisions) on the path to the current node. Once the
+    * limit stops the search, `path()` holds the decisions leading to the node where it stopped.
+    * An alternative that does not post exactly one decision appears as an undefined literal (variable -1).
+    */
+   void trackPath(bool on) noexcept { _track = on;}
+   const std::vector<Literal>& path() const noexcept { return _path;}
    // DFSearch(StateManager::Ptr sm,std::function<Branches(void)>&& b)
    //    : _sm(sm),_branching(std::move(b)) {
    //    _sm->enable();
@@ -138,17 +177,88 @@ public:
    SearchStatistics optimize(Objective::Ptr obj,SearchStatistics& stat);
    SearchStatistics optimize(Objective::Ptr obj,Limit limit);
    SearchStatistics optimize(Objective::Ptr obj);
+   /**
+    * Optimizes within the subproblem obtained by running `subjectTo` first (it may fail). The state is
+    * restored afterwards while the objective keeps the best bound found, which makes it the building
+    * block of large neighborhood search (see LNS).
+    */
    SearchStatistics optimizeSubjectTo(Objective::Ptr obj,Limit limit,std::function<void(void)> subjectTo);
 };
 
+/**
+ * Schedules of failure limits for the runs of a RestartSearch. A schedule maps the index
+ * of a run (starting at 0) to the number of failures allowed in that run.
+ */
+namespace Restart {
+   typedef std::function<long(int)> Schedule;
+   /**
+    * The Luby sequence (1,1,2,1,1,2,4,1,1,2,...) scaled by `scale`.
+    */
+   Schedule luby(long scale);
+   /**
+    * The geometric sequence \f$base \cdot factor^i\f$.
+    */
+   Schedule geometric(long base,double factor);
+};
+
+/**
+ * @brief Depth-first search restarted from the root every time the current run reaches its failure limit.
+ *
+ * The failure limits of the runs follow a schedule (see Restart::luby and Restart::geometric).
+ * The branching is expected to be randomized (e.g., with the randomized `selectMin`) so that the
+ * runs explore different parts of the search space. Each interrupted run leaves nogoods at the root:
+ * for every refuted alternative \f$x \neq v\f$ on the branch it was exploring, the decisions
+ * \f$x_i = v_i\f$ above it and \f$x = v\f$ cannot all hold (that subtree was fully explored).
+ * Like for ParallelDFSearch, alternatives are expected to post a single decision through
+ * `CPSolver::post(ConstraintDesc::Ptr)`; a branch only yields nogoods above its first alternative that does not,
+ * or that splits a domain (\f$x \leq v\f$ / \f$x \geq v\f$).
+ *
+ * Solutions found by one run may be found again by the next: `solve` stops at the first solution and
+ * `optimize` only reports improving ones. The search is complete when a run ends before its limit.
+ */
+class RestartSearch {
+   CPSolver::Ptr       _cp;
+   DFSearch            _dfs;
+   Restart::Schedule   _schedule;
+   bool                _nogoods;
+   long                _nbRestarts;
+   long                _nbNogoods;
+   bool learn();
+   SearchStatistics& run(SearchStatistics& stats,const Limit& limit);
+public:
+   RestartSearch(CPSolver::Ptr cp,std::function<Branches(void)>&& b,Restart::Schedule schedule = Restart::luby(100))
+      : _cp(cp),_dfs(cp,std::move(b)),_schedule(schedule),_nogoods(true),_nbRestarts(0),_nbNogoods(0) {}
+   /**
+    * Turns the recording of nogoods on (the default) or off.
+    */
+   void setNogoods(bool on) noexcept { _nogoods = on;}
+   long nbRestarts() const noexcept { return _nbRestarts;}
+   long nbNogoods() const noexcept { return _nbNogoods;}
+   template <class B> void onSolution(B c) { _dfs.onSolution(std::move(c));}
+   template <class B> void onFailure(B c)  { _dfs.onFailure(std::move(c));}
+   SearchStatistics solve(SearchStatistics& stat,Limit limit);
+   SearchStatistics solve(Limit limit);
+   SearchStatistics solve();
+   SearchStatistics optimize(Objective::Ptr obj,SearchStatistics& stat,Limit limit);
+   SearchStatistics optimize(Objective::Ptr obj,Limit limit);
+   SearchStatistics optimize(Objective::Ptr obj);
+};
+
+/**
+ * A node of the frontier of BFSearch. It holds the checkpoint of the node or, when the node
+ * was spilled, the offset of its decisions in the spill file.
+ */
 class BFSNode {
 public:
    std::shared_ptr<Checkpoint> _checkpoint;
    int _objectiveValue;
    int _depth;
+   long _offset;   // -1 when the node is held in memory
    BFSNode() { }
    BFSNode(std::shared_ptr<Checkpoint> checkpoint, int objectiveValue, int depth)
-      : _checkpoint(checkpoint), _objectiveValue(objectiveValue), _depth(depth) { }
+      : _checkpoint(checkpoint), _objectiveValue(objectiveValue), _depth(depth), _offset(-1) { }
+   BFSNode(long offset, int objectiveValue, int depth)
+      : _checkpoint(nullptr), _objectiveValue(objectiveValue), _depth(depth), _offset(offset) { }
 };
 
 struct BFSNodeCompare
@@ -160,6 +270,37 @@ struct BFSNodeCompare
    }
 };
 
+/**
+ * @brief What the frontier of a BFSearch held.
+ */
+struct FrontierStats {
+   long        inMemory;      //!< checkpoints currently on the frontier
+   long        maxInMemory;   //!< most checkpoints ever on the frontier
+   long        dived;         //!< nodes explored depth-first because the frontier was full
+   long        spilled;       //!< nodes written to the spill file
+   long        reloaded;      //!< spilled nodes read back
+   std::size_t spillBytes;    //!< size of the spill file
+   long        maxPaths;      //!< most path nodes alive (levels of the checkpoint prefix tree)
+   long        maxCommands;   //!< most command nodes alive
+   std::size_t maxBytes;      //!< estimated peak memory of the frontier and of the paths it refers to
+   FrontierStats() : inMemory(0),maxInMemory(0),dived(0),spilled(0),reloaded(0),spillBytes(0),
+                     maxPaths(0),maxCommands(0),maxBytes(0) {}
+   friend std::ostream& operator<<(std::ostream& os,const FrontierStats& s) {
+      return os
+         << "Frontier = " << s.maxInMemory << " checkpoints (peak), " << s.maxBytes / 1024 << " KB (estimated peak)" << std::endl
+         << "Path Nodes = " << s.maxPaths << " (peak), Command Nodes = " << s.maxCommands << " (peak)" << std::endl
+         << "Dived = " << s.dived << std::endl
+         << "Spilled = " << s.spilled << " (" << s.spillBytes / 1024 << " KB, reloaded " << s.reloaded << ")" << std::endl;
+   }
+};
+
+/**
+ * @brief Best-first search over the nodes recorded by the Tracer of a CPSemSolver.
+ *
+ * The frontier can be bounded with `setNodeBudget`. Once it holds that many checkpoints, the
+ * children of the node being expanded no longer go on the frontier: they are either spilled to a
+ * file (see `spillTo`) or explored right away, depth-first, until their subtree is exhausted.
+ */
 class BFSearch {
    Trailer::Ptr                      _sm;
    CPSemSolver::Ptr                          _cp;
@@ -167,13 +308,34 @@ class BFSearch {
    std::vector<std::function<void(void)>>    _solutionListeners;
    std::vector<std::function<void(void)>>    _failureListeners;
    Objective::Ptr _objective;
+   long           _budget;
+   std::string    _spillName;
+   std::fstream   _spill;
+   FrontierStats  _fstats;
    void bfs(SearchStatistics& stats,const Limit& limit);
+   void dive(SearchStatistics& stats,const Limit& limit);
+   long spill(Checkpoint& node);
+   bool reload(long offset);
+   void sample(std::size_t frontierSize);
    std::shared_ptr<Checkpoint> _before;
+   std::shared_ptr<Checkpoint> _root;
 public:
    BFSearch(CPSemSolver::Ptr cp,std::function<Branches(void)>&& b)
-      : _sm(cp->getStateManager()),_cp(cp),_branching(std::move(b)) {
+      : _sm(cp->getStateManager()),_cp(cp),_branching(std::move(b)),_budget(0) {
       _sm->enable();
    }
+   /**
+    * Bounds the number of checkpoints on the frontier (0, the default, leaves it unbounded).
+    */
+   void setNodeBudget(long n) noexcept { _budget = n;}
+   /**
+    * Once the frontier is full, writes the new nodes to the file `fileName` instead of diving.
+    * A spilled node costs a few bytes of memory and is rebuilt from the root when it is selected.
+    * Only nodes reached through decisions (`x == v`, `x != v`, `x <= v`, `x >= v`) can be spilled,
+    * the others are still explored depth-first.
+    */
+   void spillTo(const std::string& fileName) { _spillName = fileName;}
+   const FrontierStats& frontierStats() const noexcept { return _fstats;}
    SearchStatistics solve(SearchStatistics& stat,Limit limit);
    SearchStatistics solve(Limit limit);
    SearchStatistics solve();
@@ -235,6 +397,35 @@ typename Container::value_type selectMin(const Container& c,Predicate test, Fun
       return *min;
 }
 
+/**
+ * Like selectMin but breaks ties uniformly at random.
+ * @param rng the random generator drawing among the elements with the smallest value
+ */
+template<class Container,typename Predicate, typename Fun>
+typename Container::value_type selectMin(const Container& c,Predicate test, Fun f,std::mt19937& rng)
+{
+   auto from = c.begin();
+   auto to = c.end();
+   auto min = to;
+   decltype(f(*from)) best {};
+   unsigned int ties = 0;
+   for(; from != to; from++) {
+      if (test(*from)) {
+         auto fv = f(*from);
+         if (min == to || fv < best) {
+            min = from;
+            best = fv;
+            ties = 1;
+         } else if (!(best < fv) && rng() % ++ties == 0)  // keeps each of the ties with probability 1/ties
+            min = from;
+      }
+   }
+   if (min == to)
+      return typename Container::value_type();
+   else
+      return *min;
+}
+
 template<class Container,typename Predicate, typename Fun>
 typename Container::value_type selectMin3(const Container& c,Predicate test, Fun f) {
    return selectMin(c,test,f,typename Container::value_type());
@@ -255,10 +446,104 @@ typename Container::value_type selectFirst(const Container& c,Predicate test)
 
 template <class Container> std::function<Branches(void)> firstFail(CPSolver::Ptr cp,const Container& c) {
    using namespace Factory;
+   auto vars = std::make_shared<UnboundVars<typename Container::value_type>>(cp->getStateManager(),c);
+   return [=]() {
+      auto sx = vars->selectMin([](const auto& x) { return x->size();});
+      if (sx) {
+         int v = sx->min();
+         return [cp,sx,v] { return cp->post(sx == v);}
+            |  [cp,sx,v] { return cp->post(sx != v);};
+      } else return Branches({});
+   };
+}
+
+/**
+ * First-fail branching breaking ties at random (e.g., to diversify the runs of a RestartSearch).
+ * @param seed the seed of the random generator
+ */
+template <class Container> std::function<Branches(void)> firstFail(CPSolver::Ptr cp,const Container& c,unsigned int seed) {
+   using namespace Factory;
+   auto rng = std::make_shared<std::mt19937>(seed);
    return [=]() {
       auto sx = selectMin(c,
                           [](const auto& x) { return x->size() > 1;},
-                          [](const auto& x) { return x->size();});
+                          [](const auto& x) { return x->size();},
+                          *rng);
+      if (sx) {
+         int v = sx->min();
+         return [cp,sx,v] { return cp->post(sx == v);}
+            |  [cp,sx,v] { return cp->post(sx != v);};
+      } else return Branches({});
+   };
+}
+
+/**
+ * First-fail branching backed by a VarHeap: it makes the same choices as firstFail without scanning
+ * the variables at every node. It posts the heap, so it must be created at the root.
+ */
+template <class Container> std::function<Branches(void)> firstFailHeap(CPSolver::Ptr cp,const Container& c) {
+   using namespace Factory;
+   VarHeap::Ptr heap = new (cp) VarHeap(cp,c);
+   cp->post(heap);
+   return [=]() {
+      auto sx = heap->top();
+      if (sx) {
+         int v = sx->min();
+         return [cp,sx,v] { return cp->post(sx == v);}
+            |  [cp,sx,v] { return cp->post(sx != v);};
+      } else return Branches({});
+   };
+}
+
+/**
+ * dom/wdeg branching: selects the unbound variable with the smallest ratio of its domain size to its
+ * weighted degree (see var<int>::weightedDegree), so that the variables of the constraints that fail
+ * the most are tried first.
+ */
+template <class Container> std::function<Branches(void)> domWdeg(CPSolver::Ptr cp,const Container& c) {
+   using namespace Factory;
+   auto vars = std::make_shared<UnboundVars<typename Container::value_type>>(cp->getStateManager(),c);
+   return [=]() {
+      auto sx = vars->selectMin([](const auto& x) { return (double)x->size() / x->weightedDegree();});
+      if (sx) {
+         int v = sx->min();
+         return [cp,sx,v] { return cp->post(sx == v);}
+            |  [cp,sx,v] { return cp->post(sx != v);};
+      } else return Branches({});
+   };
+}
+
+/**
+ * Activity-based branching: selects the unbound variable with the smallest ratio of its domain size to
+ * its activity (see Scores). It turns the scoring of the solver on. Views have no activity.
+ */
+template <class Container> std::function<Branches(void)> activityBased(CPSolver::Ptr cp,const Container& c) {
+   using namespace Factory;
+   cp->setScoring(true);
+   auto vars = std::make_shared<UnboundVars<typename Container::value_type>>(cp->getStateManager(),c);
+   return [=]() {
+      Scores* sc = cp->scores();
+      auto sx = vars->selectMin([sc](const auto& x) { return x->size() / (1.0 + sc->activity(x->getId()));});
+      if (sx) {
+         int v = sx->min();
+         return [cp,sx,v] { return cp->post(sx == v);}
+            |  [cp,sx,v] { return cp->post(sx != v);};
+      } else return Branches({});
+   };
+}
+
+/**
+ * Impact-based branching: selects the unbound variable with the smallest domain size once scaled by
+ * \f$1 - impact\f$ (see Scores), so that the decisions that shrink the search space the most come first.
+ * It turns the scoring of the solver on. Views have no impact.
+ */
+template <class Container> std::function<Branches(void)> impactBased(CPSolver::Ptr cp,const Container& c) {
+   using namespace Factory;
+   cp->setScoring(true);
+   auto vars = std::make_shared<UnboundVars<typename Container::value_type>>(cp->getStateManager(),c);
+   return [=]() {
+      Scores* sc = cp->scores();
+      auto sx = vars->selectMin([sc](const auto& x) { return x->size() * (1.0 - sc->impact(x->getId()));});
       if (sx) {
          int v = sx->min();
          return [cp,sx,v] { return cp->post(sx == v);}
@@ -269,10 +554,9 @@ template <class Container> std::function<Branches(void)> firstFail(CPSolver::Ptr
 
 template <class Container> std::function<Branches(void)> smallest(CPSolver::Ptr cp,const Container& c) {
    using namespace Factory;
+   auto vars = std::make_shared<UnboundVars<typename Container::value_type>>(cp->getStateManager(),c);
    return [=]() {
-      auto sx = selectMin(c,
-                          [](const auto& x) { return x->size() > 1;},
-                          [](const auto& x) { return x->min();});
+      auto sx = vars->selectMin([](const auto& x) { return x->min();});
       if (sx) {
          int v = sx->min();
          return [cp,sx,v] { return cp->post(sx == v);}
@@ -311,6 +595,34 @@ Var first_fail(Vars const & vars) {
                     );
 }
 
+template<class Vars, class Var>
+Var dom_w_deg(Vars const & vars) {
+   return selectMin(
+                    vars,
+                    [](const auto& x) { return x->size() > 1;},
+                    [](const auto& x) { return (double)x->size() / x->weightedDegree();}
+                    );
+}
+
+// `sc` holds the scores of the solver of the variables (see CPSolver::setScoring)
+template<class Vars, class Var>
+Var activity(Vars const & vars, Scores* sc) {
+   return selectMin(
+                    vars,
+                    [](const auto& x) { return x->size() > 1;},
+                    [sc](const auto& x) { return x->size() / (1.0 + sc->activity(x->getId()));}
+                    );
+}
+
+template<class Vars, class Var>
+Var impact(Vars const & vars, Scores* sc) {
+   return selectMin(
+                    vars,
+                    [](const auto& x) { return x->size() > 1;},
+                    [sc](const auto& x) { return x->size() * (1.0 - sc->impact(x->getId()));}
+                    );
+}
+
 template<class Vars, class Var>
 Var input_order(Vars const & vars) {
    return selectMin(
@@ -0,0 +1,71 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "snapshot.hpp"
+#include <algorithm>
+
+Snapshot::Anchor Snapshot::anchor(Trailer::Ptr t,Storage::Ptr s)
+{
+   return Anchor { t->_rtop,s->_seg,s->_top };
+}
+
+void Snapshot::add(void* at,std::size_t len)
+{
+   _regions.push_back(Region { (char*)at,len,_bytes.size() });
+   _bytes.insert(_bytes.end(),(char*)at,(char*)at + len);
+}
+
+Snapshot* Snapshot::capture(Trailer::Ptr t,Storage::Ptr s,const Anchor& a)
+{
+   std::vector<std::pair<char*,std::size_t>> cells;
+   auto collect = [&cells](void* at,std::size_t len) { cells.emplace_back((char*)at,len);};
+   for(std::size_t i = a._records;i < t->_rtop;i++) {
+      const auto& r = t->_rec[i];
+      if (r._kind)
+         collect(r._at,r._kind);
+      else if (!r._entry->regions(collect))
+         return nullptr;
+   }
+   std::sort(cells.begin(),cells.end());
+   cells.erase(std::unique(cells.begin(),cells.end()),cells.end());
+
+   Snapshot* snap = new Snapshot;
+   const unsigned seg = s->_seg;
+   for(unsigned k = a._seg;k <= seg;k++) {   // storage allocated since the anchor
+      std::size_t from = k == a._seg ? a._top : 0;
+      std::size_t to   = k == seg ? (std::size_t)s->_top : s->_store[k]->_sz;
+      if (to > from)
+         snap->add(s->_store[k]->_base + from,to - from);
+   }
+   const std::size_t nbBlocks = snap->_regions.size();
+   for(const auto& c : cells) {
+      bool inside = false;      // already copied with the storage
+      for(std::size_t k = 0;k < nbBlocks && !inside;k++) {
+         const Region& b = snap->_regions[k];
+         inside = c.first >= b._at && c.first + c.second <= b._at + b._len;
+      }
+      if (!inside)
+         snap->add(c.first,c.second);
+   }
+   for(std::size_t k = 0;k < t->_nbTracked;k++)
+      snap->add(t->_tracked[k].first,t->_tracked[k].second);
+   return snap;
+}
+
+void Snapshot::apply(Trailer::Ptr t) const
+{
+   for(const auto& r : _regions)
+      t->write(r._at,_bytes.data() + r._ofs,r._len);
+}
@@ -0,0 +1,79 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include <vector>
+#include "trail.hpp"
+#include "store.hpp"
+
+/**
+ * @brief A copy of the state of a solver, relative to an anchor.
+ *
+ * Everything that changed since the anchor was taken is either memory allocated on the
+ * Storage since then or memory recorded on the trail since then. A snapshot copies both:
+ * the storage segments above the anchor and the current content of every location the trail
+ * protects above the anchor. Applying the snapshot writes that content back (through
+ * `Trailer::write`, so that backtracking undoes it) and thereby jumps to the captured state
+ * from any of its ancestors, without replaying the decisions that lead to it.
+ *
+ * Memory whose updates are not trailed (such as the order of a sparse set) is copied too when it
+ * was declared with `Trailer::track`.
+ *
+ * This relies on the Storage never releasing a segment (so captured addresses stay valid), on
+ * every trail Entry describing the memory it protects (see Entry::regions) and on every
+ * untrailed piece of state being tracked.
+ * @see Tracer::setSnapshotInterval
+ */
+class Snapshot {
+   struct Region {
+      char*       _at;
+      std::size_t _len;
+      std::size_t _ofs;   // where the content lies in _bytes
+   };
+   std::vector<Region> _regions;
+   std::vector<char>     _bytes;
+   void add(void* at,std::size_t len);
+public:
+   /**
+    * @brief The point (on the trail and on the storage) a snapshot is relative to.
+    */
+   struct Anchor {
+      std::size_t _records;
+      unsigned    _seg;
+      std::size_t _top;
+   };
+   /**
+    * Takes an anchor on the current state. The trail must never be popped below it afterwards.
+    */
+   static Anchor anchor(Trailer::Ptr t,Storage::Ptr s);
+   /**
+    * Captures the current state.
+    * @return the snapshot or `nullptr` if some entry on the trail cannot describe its memory.
+    */
+   static Snapshot* capture(Trailer::Ptr t,Storage::Ptr s,const Anchor& a);
+   /**
+    * Restores the captured state, trailing the overwritten content on `t`.
+    * The current state must be an ancestor of the captured one (or the captured one itself).
+    */
+   void apply(Trailer::Ptr t) const;
+   /**
+    * The number of bytes of state held by the snapshot.
+    */
+   std::size_t size() const noexcept { return _bytes.size();}
+};
+
+#endif
@@ -19,22 +19,38 @@
 #include <iomanip>
 #include <typeindex>
 #include "tracer.hpp"
+#include "lcg.hpp"
+#include "scores.hpp"
 
-CPSolver::CPSolver()
-    : _sm(new Trailer),
+CPSolver::CPSolver(std::size_t trailSize)
+    : _sm(new Trailer(trailSize)),
       _store(new Storage(_sm))
 {
     _varId  = 0;
+    _cstrId = 0;
     _propagations = 0;
+    _avoided = 0;
+    _running = nullptr;
+    _selfWake = false;
+    _changes = 0;
+    _profiler = nullptr;
+    _lcg = nullptr;
+    _scores = nullptr;
+    _posting = nullptr;
     _nbProp = 0;
+    _decisions = nullptr;
+    _inRestore = false;
+    _inBranching = false;
 }
 
 CPSolver::~CPSolver()
 {
+   delete _profiler;
+   delete _lcg;
+   delete _scores;
    _iVars.clear();
    _store.dealloc();
    _sm.dealloc();
-   std::cout << "CPSolver::~CPSolver(" << this << ")" << std::endl;
 }
 
 void CPSolver::post(Constraint::Ptr c, bool enforceFixPoint)
@@ -42,7 +58,9 @@ void CPSolver::post(Constraint::Ptr c, bool enforceFixPoint)
    if (!c)
       return;
    ++_nbProp;
-   c->post();
+   if (_lcg && _sm->depth() > 0)
+      _lcg->distrust(c.get());
+   postConstraint(c.get());
    if (enforceFixPoint)
       fixpoint();
 }
@@ -52,16 +70,77 @@ void CPSolver::post(ConstraintDesc::Ptr c, bool enforceFixPoint)
    if (!c)
       return;
    ++_nbProp;
-   auto constraint = c->create();
-   constraint->post();
+   Literal l;
+   const bool decision = (_decisions || _scores) && c->literal(l);
+   if (_decisions && decision)
+      _decisions->push_back(l);
+   if (_scores && decision && enforceFixPoint) {   // measures the impact of the decision
+      const double before = _scores->logSpace();
+      TRYFAIL
+         postConstraint(c->create());
+         fixpoint();
+      ONFAIL
+         _scores->decided(l._var,before,true);
+         failNow();
+      ENDFAIL
+      _scores->decided(l._var,before,false);
+      return;
+   }
+   postConstraint(c->create());
    if (enforceFixPoint)
       fixpoint();
 }
 
+// Posts `c`, attributing the listeners it adds to the variables to it (see owner)
+void CPSolver::postConstraint(Constraint* c)
+{
+   Constraint* outer = _posting;
+   _posting = c;
+   TRYFAIL
+      c->post();
+   ONFAIL
+      _posting = outer;
+      failNow();
+   ENDFAIL
+   _posting = outer;
+}
+
 void CPSolver::registerVar(AVar::Ptr avar)
 {
    avar->setId(_varId++);
    _iVars.push_back(avar);
+   if (_lcg)
+      _lcg->ensure(_varId - 1);
+}
+
+void CPSolver::setProfiling(bool on)
+{
+   if (on && !_profiler)
+      _profiler = new Profiler;
+   else if (!on) {
+      delete _profiler;
+      _profiler = nullptr;
+   }
+}
+
+void CPSolver::setLearning(bool on)
+{
+   if (on && !_lcg)
+      _lcg = new LCG(this);
+   else if (!on) {
+      delete _lcg;
+      _lcg = nullptr;
+   }
+}
+
+void CPSolver::setScoring(bool on)
+{
+   if (on && !_scores)
+      _scores = new Scores(this);
+   else if (!on) {
+      delete _scores;
+      _scores = nullptr;
+   }
 }
 
 void CPSolver::notifyFixpoint()
@@ -73,18 +152,41 @@ void CPSolver::notifyFixpoint()
 void CPSolver::fixpoint()
 {
    TRYFAIL
+      if (_lcg)
+         _lcg->prepare();
+      if (_scores)
+         _scores->startFixpoint();
       notifyFixpoint();
       while (!_queue.empty()) {
          auto c = _queue.deQueue();
          c->setScheduled(false);
          if (c->isActive())
          {
-             c->propagate();
+             _running = c.get();
+             if (_profiler) {
+                _profiler->enter(_running,_changes);
+                c->propagate();
+                _profiler->leave(_changes);
+             } else
+                c->propagate();
+             _running = nullptr;
              _propagations += 1;
+             if (_selfWake) {
+                _avoided += 1;
+                _selfWake = false;
+             }
          }
       }
       assert(_queue.size() == 0);
    ONFAIL
+      if (_profiler)
+         _profiler->fail(_changes);
+      if (_running)
+         _running->incWeight();
+      if (_lcg)
+         _lcg->analyze(_running);
+      _running = nullptr;
+      _selfWake = false;
       while (!_queue.empty()) {
          _queue.deQueue()->setScheduled(false);
       }
@@ -109,7 +211,7 @@ void CPSemSolver::post(Constraint::Ptr c, bool enforceFixPoint)
    if (!c)
       return;
    ++_nbProp;
-   c->post();
+   postConstraint(c.get());
    if (enforceFixPoint)
       fixpoint();
 }
@@ -119,11 +221,13 @@ void CPSemSolver::post(ConstraintDesc::Ptr c, bool enforceFixPoint)
       return;
    ++_nbProp;
    if (_inSearch) {
-      auto saved = c->clone();
-      _tracer->addCommand(saved);
+      Literal l;
+      if (c->literal(l))
+         _tracer->addDecision(static_cast<var<int>*>(_iVars[l._var].get()),l._rel,l._val);
+      else
+         _tracer->addCommand(c->clone());
    }
-   auto constraint = c->create();
-   constraint->post();
+   postConstraint(c->create());
    if (enforceFixPoint)
       fixpoint();
 }
@@ -131,9 +235,14 @@ Tracer* CPSemSolver::tracer()
 {
    return _tracer;
 }
+void CPSemSolver::setSnapshotInterval(int k)
+{
+   _tracer->setSnapshotInterval(k);
+}
 void CPSemSolver::startSearch()
 {
    _inSearch = true;
+   _tracer->anchor(_store);
    _rootCheckpoint = _tracer->captureCheckpoint();
    _tracer->restoreCheckpoint(_rootCheckpoint,this);
    //Restore immediately otherwise will have an empty list at the start which we don't really want
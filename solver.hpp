@@ -18,11 +18,13 @@
 
 #include <list>
 #include <deque>
+#include <vector>
 #include <functional>
 #include <stdlib.h>
 #include <setjmp.h>
 #include "handle.hpp"
 #include "fail.hpp"
+#include "profiler.hpp"
 #include "store.hpp"
 #include "avar.hpp"
 #include "acstr.hpp"
@@ -32,26 +34,69 @@ typedef std::reference_wrapper<std::function<void(void)>> Closure;
 class Controller;
 class Tracer;
 class Checkpoint;
+class LCG;
+class Scores;
 
+/**
+ * @brief The propagation queue: one ring buffer per priority tier (see Constraint::UNARY ... Constraint::GLOBAL).
+ *
+ * Constraints always leave from the cheapest non-empty tier, so a propagator of a costlier tier only
+ * runs once every cheaper propagator has reached its fixpoint. A scheduled constraint is never queued
+ * twice, so a tier never holds more entries than there are constraints and its buffer only grows (by
+ * doubling) while the model is posted.
+ */
 class DEPQueue {
-   std::deque<Constraint::Ptr>  _q[2];
+   struct Ring {
+      Constraint**  _buf;
+      unsigned int  _mask;
+      unsigned int  _enter;
+      unsigned int  _exit;
+   };
+   Ring          _q[Constraint::NBPRIO];
+   unsigned int  _busy;    // bit k is set when tier k is not empty
+   std::size_t   _size;
+   void grow(Ring& r) {
+      const unsigned int cap = r._mask + 1;
+      Constraint** nb = new Constraint*[cap << 1];
+      for(unsigned int i = 0;i < cap;i++)
+         nb[i] = r._buf[(r._exit + i) & r._mask];
+      delete[] r._buf;
+      r._buf   = nb;
+      r._exit  = 0;
+      r._enter = cap;
+      r._mask  = (cap << 1) - 1;
+   }
 public:
-   DEPQueue() {}
+   DEPQueue(unsigned int capacity = 64) : _busy(0),_size(0) {
+      for(auto& r : _q) {
+         r._buf  = new Constraint*[capacity];
+         r._mask = capacity - 1;
+         r._enter = r._exit = 0;
+      }
+   }
+   ~DEPQueue() {
+      for(auto& r : _q)
+         delete[] r._buf;
+   }
    void enQueue(Constraint::Ptr& c) {
-      _q[c->getPriority()].emplace_back(c);
+      const unsigned char t = c->getPriority();
+      Ring& r = _q[t];
+      if (r._enter - r._exit > r._mask)
+         grow(r);
+      r._buf[r._enter++ & r._mask] = c.get();
+      _busy |= 1u << t;
+      ++_size;
    }
-   bool empty() const { return _q[0].empty() && _q[1].empty();}
-   auto size() const  { return _q[0].size() + _q[1].size();}
+   bool empty() const noexcept { return _busy == 0;}
+   std::size_t size() const noexcept { return _size;}
    Constraint::Ptr deQueue() {
-      if (!_q[Constraint::CHIGH].empty()) {
-         auto c = _q[Constraint::CHIGH].front();
-         _q[Constraint::CHIGH].pop_front();
-         return c;
-      } else {
-         auto c = _q[Constraint::CLOW].front();
-         _q[Constraint::CLOW].pop_front();
-         return c;
-      }
+      const unsigned int t = __builtin_ctz(_busy);   // the cheapest tier with work
+      Ring& r = _q[t];
+      Constraint* c = r._buf[r._exit++ & r._mask];
+      if (r._exit == r._enter)
+         _busy &= ~(1u << t);
+      --_size;
+      return c;
    }
 };
 
@@ -59,28 +104,102 @@ class CPSolver {
 protected:
    Trailer::Ptr                  _sm;
    Storage::Ptr               _store;
-   std::list<AVar::Ptr>       _iVars;
+   std::vector<AVar::Ptr>     _iVars;
    DEPQueue                   _queue;
    std::list<std::function<void(void)>>  _onFix;
    long                  _afterClose;
    int                        _varId;
+   unsigned long             _cstrId;   // the constraints created so far
    unsigned long long  _propagations;
+   unsigned long long        _avoided;   // wakeups of idempotent propagators by their own events
+   Constraint*               _running;   // the propagator currently running (if any)
+   bool                     _selfWake;
+   unsigned long long        _changes;   // domain updates so far
+   Profiler*                _profiler;   // nullptr unless profiling
+   LCG*                          _lcg;   // nullptr unless learning
+   Scores*                    _scores;   // nullptr unless scoring
+   Constraint*               _posting;   // the constraint being posted (if any)
    size_t                    _nbProp;
    bool                   _inRestore;
    bool                 _inBranching;
+   std::vector<Literal>*  _decisions;
+   void postConstraint(Constraint* c);
 public:
    template<typename T> friend class var;
    typedef handle_ptr<CPSolver> Ptr;
-   CPSolver();
+   /**
+    * @param trailSize the initial size (in bytes) of the trail (see Trailer::Trailer)
+    */
+   CPSolver(std::size_t trailSize = TRAILSIZE);
    ~CPSolver();
    Trailer::Ptr getStateManager()       { return _sm;}
    Storage::Ptr getStore()              { return _store;}
    unsigned long long getPropagations() {return _propagations;};
+   /**
+    * @return the number of times an idempotent propagator was not scheduled again after it modified its own variables
+    * @see Constraint::setIdempotent
+    */
+   unsigned long long getAvoidedWakeups() const noexcept { return _avoided;}
+   /**
+    * Turns the profiling of the propagators on (or off, which discards the profile).
+    * While it is on, every propagation is timed and accounted to its constraint.
+    * @see Profiler
+    */
+   void setProfiling(bool on);
+   /**
+    * @return the profile of the propagators (`nullptr` unless profiling is on)
+    */
+   Profiler* profiler() noexcept { return _profiler;}
+   /**
+    * Turns lazy clause generation on (or off, which forgets the learned clauses). It must be turned
+    * on at the root, before the constraints are posted.
+    * @see LCG
+    */
+   void setLearning(bool on);
+   /**
+    * @return the clause learning engine (`nullptr` unless learning is on)
+    */
+   LCG* learner() noexcept { return _lcg;}
+   /**
+    * @return the propagator currently running (`nullptr` outside of the propagation loop)
+    */
+   Constraint* running() const noexcept { return _running;}
+   /**
+    * @return the constraint the listeners added to a variable right now belong to: the constraint
+    * being posted or, when none, the propagator running (`nullptr` otherwise)
+    * @see var<int>::weightedDegree
+    */
+   Constraint* owner() const noexcept { return _posting ? _posting : _running;}
+   /**
+    * Turns the scoring of the variables for the adaptive branchings on (or off, which discards the scores).
+    * @see Scores
+    */
+   void setScoring(bool on);
+   /**
+    * @return the activity and impact of the variables (`nullptr` unless scoring is on)
+    */
+   Scores* scores() noexcept { return _scores;}
+   /**
+    * Called by the variables on every update of a domain
+    */
+   void notifyChange() noexcept { ++_changes;}
    size_t getNbVars() noexcept { return _iVars.size();}
    size_t getNbProp() noexcept { return _nbProp;}
     void registerVar(AVar::Ptr avar);
+    unsigned long nextConstraintId() noexcept { return _cstrId++;}   // see Constraint::getId
+    AVar::Ptr varAt(int id) noexcept { return _iVars[id];}
+    /**
+     * Starts (or stops) recording the literals posted through `post(ConstraintDesc::Ptr)`.
+     * @param into the vector receiving the literals. `nullptr` stops the recording.
+     * @see ConstraintDesc::literal, Factory::decision
+     */
+    void recordDecisions(std::vector<Literal>* into) noexcept { _decisions = into;}
     void schedule(Constraint::Ptr& c) {
         if (c->isActive() && !c->isScheduled()) {
+            if (c.get() == _running && c->isIdempotent()) {
+                _selfWake = true;
+                return;
+            }
             c->setScheduled(true);
             _queue.enQueue(c);
         }
@@ -115,15 +234,23 @@ public:
     void post(Constraint::Ptr c,bool enforceFixPoint=true);
     void post(ConstraintDesc::Ptr c,bool enforceFixPoint=true);
     Tracer* tracer();
+    /**
+     * Copies the state every `k` levels of the search so that restoring a checkpoint
+     * only recomputes the levels below the closest copy (0, the default, always recomputes
+     * from the deepest level shared with the current node).
+     * @see Tracer::setSnapshotInterval
+     */
+    void setSnapshotInterval(int k);
     void startSearch();
 };
 
 namespace Factory {
    /**
     * Factory method to allocate a new CP solver.
+    * @param trailSize the initial size (in bytes) of the trail. It grows on demand.
     * @return a pointer to a solver.
     */
-   inline CPSolver::Ptr makeSolver() { return new CPSolver;}
+   inline CPSolver::Ptr makeSolver(std::size_t trailSize = TRAILSIZE) { return new CPSolver(trailSize);}
    inline CPSemSolver::Ptr makeSemSolver() { return new CPSemSolver;}
 };
 
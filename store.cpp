@@ -61,10 +61,12 @@ void* Storage::allocate(std::size_t sz)
    assert((sz & 0xF) == 0 && sz != 0);           // check alignment
    auto s = _store[_seg];
    if (_top + sz >= s->_sz) {
-      while (_store.size() != _seg + 1)
-         _store.pop_back();                    // discard old segments
-      _store.push_back(std::make_shared<Storage::Segment>(std::max(_segSize,sz)));
-      _seg = _seg + 1;
+      unsigned ns = _seg + 1;
+      while (ns < _store.size() && _store[ns]->_sz < sz)
+         ++ns;                                 // reuse the segments left over by backtracking
+      if (ns == _store.size())
+         _store.push_back(std::make_shared<Storage::Segment>(std::max(_segSize,sz)));
+      _seg = ns;
       _top = 0;
       s = _store[_seg];
    }
@@ -36,6 +36,7 @@
  * returning to.
  */
 class Storage {
+   friend class Snapshot;
    struct Segment {
       char*      _base;
       std::size_t  _sz;
@@ -57,7 +58,8 @@ public:
     * 
     * Note that when a segment is full, the allocator automatically grabs another segment
     * to serve the latest allocation request. Therefore, the allocator keeps a vector of
-    * Segments that is shrunk/reused as needed on backtrack.
+    * Segments that is reused as needed on backtrack. Segments are never released before
+    * the allocator itself, so an address handed out stays valid (see Snapshot).
     */
    Storage(Trailer::Ptr ctx,std::size_t defSize = SEGSIZE); 
    ~Storage();
@@ -23,7 +23,7 @@ void TableCT::post()
    int currIndex = 0;
    for (const auto& vp : _vars) {
       _entries.emplace(vp->getId(), Entry(currIndex, vp->min(), vp->max()));  // build entries for each var
-      _lastSizes.push_back(trail<int>(vp->getSolver()->getStateManager(), vp->size()));  // record initial var domain size
+      _deltas.emplace_back();
       _supports.emplace_back(std::vector<StaticBitSet>(0));  // init vector of bitsets for var's supports
       _residues.emplace_back(std::vector<int>());
       std::vector<StaticBitSet>& v = _supports.back();
@@ -64,29 +64,52 @@ void TableCT::post()
    }
    //std::cout << "table::post \tCT:" << _currTable << "\n";
    propagate();
-   for (const auto& vp : _vars)
-      vp->propagateOnDomainChange(this); // for each variable, propagate on change to domain
+   for (auto i=0u; i < _vars.size(); i++)
+      _vars[i]->adviseOnDomainChange(this,i); // for each variable, be advised of the values it loses
+}
+
+bool TableCT::advise(int idx,const IntDelta& d)
+{
+   if (_filtering)      // the values filterDomains removes have no support left: the table is unchanged
+      return false;
+   if (_seen != _recorded)   // some deltas belong to a state undone since (e.g., a failure outside of the fixpoint)
+      dropDeltas();
+   if (!_rescan) {
+      if (_deltas[idx].empty())
+         _touched.push_back(idx);
+      _deltas[idx].push_back(d);
+   }
+   _seen = ++_recorded;
+   return true;
+}
+
+// The deltas no longer match the trailed table: forget them and rebuild the table from the domains.
+void TableCT::dropDeltas()
+{
+   for (int k : _touched)
+      _deltas[k].clear();
+   _touched.clear();
+   _rescan = true;
 }
 
 void TableCT::propagate()  // enforceGAC
 {
-   // calculate Sval
-   _Sval.clear();
+   // calculate Ssup (Sval is the set of the variables with deltas)
    _Ssup.clear();
-   for (const auto& vp : _vars) {
-      const int varIndex = _entries.at(vp->getId()).getIndex();
-      if (vp->size() != _lastSizes[varIndex]) {
-         _Sval.push_back(vp);
-         _lastSizes[varIndex] = vp->size();  // update lastSizes for vars in Sval
-      }
-      // calculate Ssup
+   for (const auto& vp : _vars)
       if (vp->size() > 1)
          _Ssup.push_back(vp);
-   }
    updateTable();
    if (_currTable.isEmpty())
       failNow();
-   filterDomains();
+   _filtering = true;
+   TRYFAIL
+      filterDomains();
+   ONFAIL
+      _filtering = false;
+      failNow();
+   ENDFAIL
+   _filtering = false;
 }
 
 void TableCT::filterDomains()
@@ -94,38 +117,64 @@ void TableCT::filterDomains()
    for (const auto& vp : _Ssup) {
       const int varIndex = _entries.at(vp->getId()).getIndex();
       const int iMin = _entries.at(vp->getId()).getMin();
-      for (int val = vp->min(); val < vp->max() + 1; val++) {
+      const int vMax = vp->max();
+      _lost.clear();
+      for (int val = vp->min(); val <= vMax; val++) {
+         if (!vp->contains(val))
+            continue;
          const int valIndex = val - iMin;
          int wIndex = _residues[varIndex][valIndex];
          if (wIndex == -1) 
-            vp->remove(val);         
+            _lost.push_back(val);
          else {
             if ((_currTable[wIndex] & _supports[varIndex][valIndex][wIndex]) == 0) {
                wIndex = _currTable.intersectIndex(_supports[varIndex][valIndex]);
                if (wIndex != -1) 
                   _residues[varIndex][valIndex] = wIndex;              
                else 
-                  vp->remove(val);               
+                  _lost.push_back(val);
             }
          }
       }
-      _lastSizes[varIndex] = vp->size();
+      if (!_lost.empty())
+         vp->removeSet(_lost);   // one notification for all the values without support
    }
 }
 
 void TableCT::updateTable()
 {
-   for (const auto& vp : _Sval) {
-      const int varIndex = _entries.at(vp->getId()).getIndex();
+   if (_seen != _recorded)
+      dropDeltas();
+   if (_rescan)
+      for (auto k = 0u; k < _vars.size(); k++)
+         _touched.push_back(k);
+   for (int varIndex : _touched) {
+      const auto& vp = _vars[varIndex];
       const int iMin = _entries.at(vp->getId()).getMin();
+      int span = 0;
+      for (const auto& d : _deltas[varIndex])
+         span += d.span();
       _currTable.clearMask();
-      for (int val = vp->min(); val < vp->max() + 1; val++) {
-         const int valIndex = val - iMin;
-         if (vp->contains(val))
-            _currTable.addToMask(_supports[varIndex][valIndex]);
+      if (!_rescan && span < vp->size()) {  // cheaper to clear the supports of the values lost than to keep those of the values left
+         for (const auto& d : _deltas[varIndex])
+            d.removed([this,varIndex,iMin](int val) {
+                         _currTable.addToMask(_supports[varIndex][val - iMin]);
+                      });
+         _currTable.reverseMask();
+      } else {
+         for (int val = vp->min(); val < vp->max() + 1; val++) {
+            const int valIndex = val - iMin;
+            if (vp->contains(val))
+               _currTable.addToMask(_supports[varIndex][valIndex]);
+         }
       }
       _currTable.intersectWithMask();
       if (_currTable.isEmpty())
          break;
    }
+   for (int k : _touched)
+      _deltas[k].clear();
+   _touched.clear();
+   _rescan = false;
+   _seen = ++_recorded;
 }
@@ -48,23 +48,36 @@ class TableCT : public Constraint {
    std::vector<std::vector<int>>                       _residues;
    SparseBitSet                                        _currTable;
    std::vector<var<int>::Ptr>                          _vars;
-   std::vector<var<int>::Ptr>                          _Sval;
    std::vector<var<int>::Ptr>                          _Ssup;
-   std::vector<trail<int>>                             _lastSizes;
+   std::vector<std::vector<IntDelta>>                  _deltas;      // per variable, the changes since the last propagation
+   std::vector<int>                                    _touched;     // the variables with deltas
+   std::vector<int>                                    _lost;        // the values filterDomains removes from a variable
+   trail<long>                                         _seen;        // _recorded when the deltas were last changed, restored on backtrack
+   long                                                _recorded;    // the changes made to the deltas so far
+   bool                                                _rescan;      // the deltas are lost: rebuild the table from all the domains
+   bool                                                _filtering;
    void                                                filterDomains();
    void                                                updateTable();
+   void                                                dropDeltas();
 public:
    template <class Vec> TableCT(const Vec& x, const std::vector<std::vector<int>>& table)
       : Constraint(x[0]->getSolver()),
         _table(table),
-        _currTable(x[0]->getSolver()->getStateManager(), x[0]->getStore(), table.size())  // build SparseBitSet for vectors in table
+        _currTable(x[0]->getSolver()->getStateManager(), x[0]->getStore(), table.size()),  // build SparseBitSet for vectors in table
+        _seen(x[0]->getSolver()->getStateManager(), 0),
+        _recorded(0),
+        _rescan(false),
+        _filtering(false)
    {
+      setPriority(GLOBAL);
+      setIdempotent(true);
       for (const auto& vp : x) 
          _vars.push_back(vp);
    }
    ~TableCT() {}
    void post() override;
    void propagate() override;
+   bool advise(int idx,const IntDelta& d) override;
 };
 
 namespace Factory {
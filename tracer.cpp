@@ -15,14 +15,26 @@
 
 #include "tracer.hpp"
 #include "fail.hpp"
+#include "RuntimeMonitor.hpp"
 
 Tracer::Tracer(Trailer::Ptr trail/*, MemoryTrail* memoryTrail*/)
-   : _trail(trail)/*, _memoryTrail(memoryTrail)*/ {
+   : _trail(trail)/*, _memoryTrail(memoryTrail)*/,
+     _lastNodeID(0),
+     _store(nullptr),
+     _anchor({0,0,0}),
+     _interval(0),
+     _nbSnapshots(0),
+     _snapshotBytes(0) {
    _commands = new CommandStack(32);
    _commands->pushList(_lastNodeID);
+   _exact.push_back(true);
    _lastNodeID++;
    _level = 1;
 }
+void Tracer::anchor(Storage::Ptr store) {
+   _store  = store;
+   _anchor = Snapshot::anchor(_trail,store);
+}
 unsigned int Tracer::currentNode() {
    return _lastNodeID;
 }
@@ -31,6 +43,7 @@ void Tracer::fail() {
 }
 unsigned int Tracer::pushNode() {
    _commands->pushList(_lastNodeID);/*, _memoryTrail->trailSize()*/
+   _exact.push_back(true);
    _lastNodeID++;
    _trail->push();
    assert(_trail->depth() <= 1 || _commands->size() == _trail->depth());
@@ -41,6 +54,7 @@ CommandList* Tracer::popNode() {
    _trail->pop();
    _trail->incMagic();
    CommandList* list = _commands->popList();
+   _exact.pop_back();
    assert(_commands->size() == _trail->depth());
    return list;
 }
@@ -59,45 +73,147 @@ Trailer::Ptr Tracer::trail() {
 void Tracer::addCommand(ConstraintDesc::Ptr command) {
    _commands->addCommand(command);
 }
+void Tracer::addDecision(var<int>* x,Literal::Rel rel,int val) {
+   _commands->addDecision(x,rel,val);
+}
+void Tracer::truncate(unsigned int size) {
+   while ((unsigned)_commands->size() > size) {
+      _trail->pop();
+      _commands->popList()->letgo();
+      _exact.pop_back();
+   }
+}
+PathNode* Tracer::share() {
+   const unsigned int n = _commands->size();
+   PathNode* parent = nullptr;
+   unsigned int k = 0;
+   while (k < n && k < _prefix.size() && _prefix[k]->_list == _commands->peekAt(k))
+      parent = _prefix[k++];
+   for (unsigned int j = k; j < _prefix.size(); j++)
+      PathNode::release(_prefix[j]);
+   _prefix.resize(k);
+   for (; k < n; k++) {               // the levels that are not in the tree yet
+      CommandList* list = _commands->peekAt(k);
+      list->freeze();
+      parent = PathNode::make(list->grab(),parent);
+      _prefix.push_back(parent);
+   }
+   if (parent)
+      parent->_refs++;
+   return parent;
+}
+void Tracer::adopt(PathNode* tail) {
+   for (PathNode* p : _prefix)
+      PathNode::release(p);
+   _prefix.resize(tail ? tail->_depth : 0);
+   for (PathNode* p = tail; p; p = p->_parent) {
+      p->_refs++;
+      _prefix[p->_depth - 1] = p;
+   }
+}
 std::shared_ptr<Checkpoint> Tracer::captureCheckpoint() {
-   std::shared_ptr<Checkpoint> checkpoint (new Checkpoint(_commands));//, _memoryTrail);
+   std::shared_ptr<Checkpoint> checkpoint (new Checkpoint(share()));//, _memoryTrail);
    checkpoint->setLevel(_level);
+   if (_interval > 0 && _store && _commands->size() % _interval == 0) {
+      CommandList* top = _commands->peekAt(_commands->size() - 1);
+      if (!top->snapshot()) {
+         Snapshot* snap = Snapshot::capture(_trail,_store,_anchor);
+         if (snap) {
+            top->setSnapshot(snap);
+            _nbSnapshots += 1;
+            _snapshotBytes += snap->size();
+         } else _interval = 0;
+      }
+   }
    checkpoint->setNodeID(pushNode());
    return checkpoint;
 }
+bool Tracer::replay(CommandList* list,CPSemSolver::Ptr solver) {
+   bool ok = true;
+   _replay.levels += 1;
+   TRYFAIL
+      for (struct CommandNode* node = list->head(); node != nullptr; node = node->_next) {
+         _replay.commands += 1;
+         if (node->isDecision()) {
+            _replay.decisions += 1;
+            switch(node->_rel) {
+               case Literal::EQ:  node->_x->assign(node->_val);break;
+               case Literal::NEQ: node->_x->remove(node->_val);break;
+               case Literal::LEQ: node->_x->removeAbove(node->_val);break;
+               default:           node->_x->removeBelow(node->_val);break;
+            }
+         } else
+            solver->post(node->_constraint->create(),false);
+      }
+      solver->fixpoint();
+   ONFAIL
+      ok = false;
+   ENDFAIL
+   return ok;
+}
 bool Tracer::restoreCheckpoint(std::shared_ptr<Checkpoint> checkpoint, CPSemSolver::Ptr solver) {
+   auto start = RuntimeMonitor::now();
+   const long replayed = _replay.commands;
+   auto done = [this,start,replayed,solver](bool ok) {
+      _replay.restores += 1;
+      _replay.lastLength = (unsigned int)(_replay.commands - replayed);
+      _replay.lastTime = RuntimeMonitor::elapsedSinceMicro(start) / 1000.0;
+      _replay.time += _replay.lastTime;
+      if (_replay.lastLength > _replay.maxLength)
+         _replay.maxLength = _replay.lastLength;
+      solver->endRestore();
+      return ok;
+   };
    solver->startRestore();
-   CommandStack* restoreStack = checkpoint->commands();
+   checkpoint->path(_path);
+   adopt(checkpoint->tail());   // the lists of the restored levels are those of the path
    unsigned int currentSize = _commands->size();
-   unsigned int restoreToSize = restoreStack->size();
-   unsigned int i = _commands->sharedPrefixSize(restoreStack);
+   unsigned int restoreToSize = _path.size();
+   unsigned int i = _commands->sharedPrefixSize(_path);
+   while (i > 1 && !_exact[i - 1])   // levels below a jump to a snapshot hold no state of their own
+      --i;
    while (i != currentSize--) {
       _trail->pop();
       CommandList* list = _commands->popList();
       list->letgo();
+      _exact.pop_back();
    }
 
    _trail->incMagic();
-   for (; i < restoreToSize; i++) {
-      assert(_commands->size() == _trail->depth());
-      CommandList* list = restoreStack->peekAt(i);
-      _trail->push(list->nodeID());
-      _commands->pushList(list->nodeID());
+   unsigned int from = i;              // the deepest snapshot on the path to the checkpoint
+   for (unsigned int k = restoreToSize; k > i && from == i; k--)
+      if (_path[k - 1]->snapshot())
+         from = k;
+   if (from > i) {
+      const unsigned int base = i;
       TRYFAIL
-         struct CommandNode* node = list->head();
-         while (node != nullptr) {
-            solver->post(node->_constraint);
-            node = node->_next;
+         for (unsigned int k = base; k < from; k++) {
+            CommandList* list = _path[k];
+            _trail->push(list->nodeID());
+            _commands->pushCommandList(list->grab());
+            _exact.push_back(k + 1 == from);
          }
+         _path[from - 1]->snapshot()->apply(_trail);
+         solver->fixpoint();  // enforces the bounds found since the snapshot was taken
       ONFAIL
-         _trail->pop();
-         _commands->popList();
-         assert(_trail->depth() <= 1 || _commands->size() == _trail->depth());
-         solver->endRestore();
-         return false;
+         truncate(base);
+         return done(false);
       ENDFAIL
+      _replay.jumps += 1;
+      i = from;
+   }
+   for (; i < restoreToSize; i++) {
+      assert(_commands->size() == _trail->depth());
+      CommandList* list = _path[i];
+      _trail->push(list->nodeID());
+      _commands->pushCommandList(list->grab());  // the list is frozen: new commands copy it
+      _exact.push_back(true);
+      if (!replay(list,solver)) {
+         truncate(i);
+         assert(_trail->depth() <= 1 || _commands->size() == _trail->depth());
+         return done(false);
+      }
    }
    _level = checkpoint->level();
-   solver->endRestore();
-   return true;
+   return done(true);
 }
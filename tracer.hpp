@@ -16,16 +16,77 @@
 #ifndef __TRACER_H
 #define __TRACER_H
 
+#include <iostream>
 #include "commandList.hpp"
 #include "solver.hpp"
 
+/**
+ * @brief What restoring checkpoints cost.
+ */
+struct ReplayStats {
+   long         restores;    //!< number of checkpoints restored
+   long         jumps;       //!< restores that started from a snapshot
+   long         levels;      //!< levels recomputed
+   long         commands;    //!< commands replayed (decisions included)
+   long         decisions;   //!< decisions applied directly to the domains
+   double       time;        //!< total time spent restoring (milliseconds)
+   unsigned int lastLength;  //!< commands replayed by the last restore
+   double       lastTime;    //!< duration of the last restore (milliseconds)
+   unsigned int maxLength;   //!< most commands replayed by a single restore
+   ReplayStats() : restores(0),jumps(0),levels(0),commands(0),decisions(0),time(0),
+                   lastLength(0),lastTime(0),maxLength(0) {}
+   friend std::ostream& operator<<(std::ostream& os,const ReplayStats& s) {
+      return os
+         << "Restores = " << s.restores << " (from a snapshot " << s.jumps << ")" << std::endl
+         << "Replayed Levels = " << s.levels << std::endl
+         << "Replayed Commands = " << s.commands << " (decisions " << s.decisions << ", longest " << s.maxLength << ")" << std::endl
+         << "Restore Time = " << s.time << " ms" << std::endl;
+   }
+};
+
+/**
+ * @brief Records the commands posted at every level of the search so that any node can be
+ * recomputed later (see Checkpoint).
+ *
+ * Restoring a checkpoint pops back to the longest prefix it shares with the current node and
+ * posts the commands of the remaining levels again. When snapshots are enabled (see
+ * `setSnapshotInterval`), the state is also copied every few levels and a restore starts from
+ * the deepest snapshot on the path of the checkpoint, recomputing only the levels below it.
+ */
 class Tracer {
    Trailer::Ptr _trail;
    unsigned int _lastNodeID;
    CommandStack* _commands;
    unsigned int _level;
+   std::vector<bool> _exact;   // _exact[k]: popping down to k+1 lists yields the state of list k
+   Storage::Ptr      _store;
+   Snapshot::Anchor  _anchor;
+   int               _interval;
+   long              _nbSnapshots;
+   std::size_t       _snapshotBytes;
+   ReplayStats       _replay;
+   std::vector<PathNode*>    _prefix;   // _prefix[k] is the path node of the k-th list when it is on the stack
+   std::vector<CommandList*> _path;     // the path of the checkpoint being restored
+   void truncate(unsigned int size);
+   PathNode* share();
+   void adopt(PathNode* tail);
+   bool replay(CommandList* list,CPSemSolver::Ptr solver);
 public:
    Tracer(Trailer::Ptr trail);//, MemoryTrail* memoryTrail);
+   /**
+    * Takes a snapshot of the state every `k` levels (0, the default, disables snapshots).
+    * Snapshots are relative to the anchor taken by `anchor` when the search starts.
+    * Snapshots are silently disabled if some trail entry cannot describe its memory.
+    */
+   void setSnapshotInterval(int k) noexcept { _interval = k;}
+   void anchor(Storage::Ptr store);
+   long nbSnapshots() const noexcept { return _nbSnapshots;}
+   std::size_t snapshotBytes() const noexcept { return _snapshotBytes;}
+   /**
+    * The number of restores that started from a snapshot.
+    */
+   long nbJumps() const noexcept { return _replay.jumps;}
+   const ReplayStats& replayStats() const noexcept { return _replay;}
    unsigned int currentNode();
    void fail();
    unsigned int pushNode();
@@ -34,7 +95,16 @@ public:
    unsigned int level();
    Trailer::Ptr trail();
    void addCommand(ConstraintDesc::Ptr command);
+   void addDecision(var<int>* x,Literal::Rel rel,int val);
+   /**
+    * Checkpoints taken along a branch share the levels they have in common (see PathNode).
+    */
    std::shared_ptr<Checkpoint> captureCheckpoint();
+   /**
+    * Moves the solver to the node of the checkpoint. Each recomputed level posts its commands
+    * (applying decisions directly to the domains) and then reaches a single fixpoint.
+    * @return false if the node turns out to be inconsistent
+    */
    bool restoreCheckpoint(std::shared_ptr<Checkpoint> checkpoint, CPSemSolver::Ptr solver);
 };
 
@@ -15,68 +15,111 @@
 
 #include "trail.hpp"
 #include <assert.h>
+#include <algorithm>
 #include <iostream>
 #include "commandList.hpp"
 
-#define TSIZE (1 << 28)
-
-Trailer::Trailer()
-    : _magic(-1)
+Trailer::Trailer(std::size_t initSize)
+   : _isz(initSize < sizeof(Record) ? sizeof(Record) : initSize),
+     _magic(-1)
 {
-   _block = (char*)malloc(TSIZE);
-   _bsz = TSIZE;
+   _rsz  = _isz / sizeof(Record);
+   _rec  = (Record*)malloc(sizeof(Record) * _rsz);
+   _rtop = 0;
+   _bcur = 0;
    _btop = 0;
    _lastNode = 0;
    _enabled  = false;
+   _nbTracked  = 0;
+   _maxRecords = 0;
+   _maxChunks  = 0;
+   _maxDepth   = 0;
 }
 
 Trailer::~Trailer()
 {
-   free(_block);
+   free(_rec);
+   for(auto& c : _chunks)
+      free(c._base);
 }
 
-void Trailer::resize()
+void Trailer::growRecords()
 {
-   std::cout  << "Trailer::resize to: " << (_bsz << 1) << "\n";
-   char* nb = (char*)realloc(_block,_bsz << 1);
-   if (nb != _block) {
-      std::stack<Entry*> ns;
-      while(!_trail.empty()) {
-         Entry* e = _trail.top();
-         Entry* ne = (Entry*)((char*)e - _block + nb);
-         ne->relocate(nb - _block);
-         ns.push(ne);
-         _trail.pop();
-      }
-      while(!ns.empty()) {
-         Entry* e = ns.top();
-         _trail.push(e);
-         ns.pop();
-      }
+   _rec = (Record*)realloc(_rec,sizeof(Record) * (_rsz << 1));
+   _rsz <<= 1;
+}
+
+void Trailer::nextChunk(std::size_t sz)
+{
+   if (_bcur < _chunks.size())
+      ++_bcur;
+   while (_bcur < _chunks.size() && _chunks[_bcur]._sz < sz)
+      ++_bcur;
+   if (_bcur == _chunks.size()) {
+      std::size_t csz = _chunks.empty() ? _isz : _chunks.back()._sz << 1;
+      if (csz < sz) csz = sz;
+      _chunks.push_back(Chunk {(char*)malloc(csz),csz});
+   }
+   _btop = 0;
+   if (_bcur + 1 > _maxChunks)
+      _maxChunks = _bcur + 1;
+}
+
+void Trailer::track(void* at,std::size_t len)
+{
+   save(&_nbTracked);
+   if (_nbTracked < _tracked.size())
+      _tracked[_nbTracked] = std::make_pair(at,len);
+   else _tracked.emplace_back(at,len);
+   ++_nbTracked;
+}
+
+void Trailer::write(void* at,const void* src,std::size_t len)
+{
+   if (_enabled) {
+      if (len == 1 || len == 2 || len == 4 || len == 8) {
+         Record* r = newRecord();
+         r->_at   = at;
+         r->_u64  = 0;
+         std::memcpy(&r->_u64,at,len);
+         r->_kind = (int)len;
+      } else
+         trail(new (allocate(sizeof(BlockEntry) + len)) BlockEntry(at,len));
    }
-   _bsz <<= 1;
-   _block = nb;
+   std::memcpy(at,src,len);
+}
+
+Trailer::Stats Trailer::stats() const noexcept
+{
+   Stats s;
+   s.records    = _rtop;
+   s.maxRecords = std::max(_maxRecords,_rtop);
+   s.capacity   = _rsz;
+   s.chunks     = _chunks.size();
+   s.maxChunks  = _maxChunks;
+   s.bytes      = _rsz * sizeof(Record);
+   for(const auto& c : _chunks)
+      s.bytes += c._sz;
+   s.maxDepth   = std::max(_maxDepth,(int)_tops.size());
+   return s;
 }
 
 long Trailer::push()
 {
     ++_magic;
     long rv = ++_lastNode;
-    _tops.emplace(std::make_tuple(_trail.size(),_btop,rv));
+    _tops.push_back(Level {_rtop,_bcur,_btop,rv});
     return rv;
 }
 void Trailer::push(long nodeID)
 {
     ++_magic;
-    _tops.emplace(std::make_tuple(_trail.size(),_btop,nodeID));
+    _tops.push_back(Level {_rtop,_bcur,_btop,nodeID});
 }
 void Trailer::popToNode(long node)
 {
   while (true) {
-    int to;
-    std::size_t mem;
-    long nodeId;
-    std::tie(to,mem,nodeId) = _tops.top();
+    long nodeId = _tops.back()._node;
     pop();
     if (nodeId == node)
       break;
@@ -85,19 +128,31 @@ void Trailer::popToNode(long node)
 
 void Trailer::pop()
 {
-   unsigned to;
-   std::size_t mem;
-   long node;
-   std::tie(to,mem,node) = _tops.top();
-   _tops.pop();
-   while (_trail.size() != to) {
-      assert(_trail.size() >= to);
-      Entry* entry = _trail.top();
-      entry->restore();
-      _trail.pop();
-      entry->Entry::~Entry();
+   const Level& lvl = _tops.back();
+   assert(_rtop >= lvl._rtop);
+   if (_rtop > _maxRecords)
+      _maxRecords = _rtop;
+   if ((int)_tops.size() > _maxDepth)
+      _maxDepth = (int)_tops.size();
+   Record* const stop = _rec + lvl._rtop;
+   Record* r = _rec + _rtop;
+   while (r != stop) {
+      --r;
+      switch(r->_kind) {
+         case 4: std::memcpy(r->_at,&r->_u64,4);break;  // fixed-size copies compile to single stores
+         case 8: std::memcpy(r->_at,&r->_u64,8);break;
+         case 1: std::memcpy(r->_at,&r->_u64,1);break;
+         case 2: std::memcpy(r->_at,&r->_u64,2);break;
+         default:
+            r->_entry->restore();
+            r->_entry->Entry::~Entry();
+            break;
+      }
    }
-   _btop = mem;
+   _rtop = lvl._rtop;
+   _bcur = lvl._bcur;
+   _btop = lvl._btop;
+   _tops.pop_back();
 }
 
 void Trailer::clear()
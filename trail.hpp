@@ -17,33 +17,189 @@
 #define __TRAIL_H
 
 #include <memory>
-#include <stack>
-#include <tuple>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
 #include <vector>
 #include "state.hpp"
 
 class Entry {
 public:
-   virtual void relocate(long) noexcept {}
    virtual void restore() noexcept = 0;
+   /**
+    * Reports the memory the entry restores, one (address,length) region at a time.
+    * This is what a Snapshot copies to capture the state protected by the entry.
+    * @return false if the entry cannot describe that memory (the default).
+    */
+   virtual bool regions(const std::function<void(void*,std::size_t)>& f) const { return false;}
 };
 
+/**
+ * Default initial size (in bytes) of the record array and of the first entry chunk of a Trailer.
+ */
+#define TRAILSIZE (1 << 16)
+
+/**
+ * @brief The trailing state manager.
+ *
+ * The trail is a single contiguous array of records. Writes to plain values (integers, pointers,
+ * booleans, ... any trivially copyable type of 1, 2, 4 or 8 bytes) are recorded with `save` as
+ * an (address, old value, size) record that is restored with a store of the right width: no
+ * object is allocated and no virtual call is made on backtrack.
+ * Anything more complex is recorded as an `Entry` (allocated on the trailer with `new (t)`)
+ * whose `restore` method is called on backtrack.
+ *
+ * Memory is acquired lazily. The record array starts at the initial size and doubles when full
+ * (records hold no pointer into the array, so moving it is harmless). Entries live in a list of
+ * chunks that never move: when the current chunk is full the next one (twice as large as the
+ * previous) is used, so no entry ever needs to be relocated. Chunks are kept on backtrack and
+ * reused when the trail grows again.
+ */
 class Trailer :public StateManager {
-   std::stack<Entry*>      _trail;
-   std::stack<std::tuple<int,std::size_t,long>>  _tops;
+   struct Record {
+      void*   _at;        // the address to restore (unused for entries)
+      union {
+         std::uint64_t _u64;      // the old value (in its first sizeof(T) bytes)
+         Entry*        _entry;
+      };
+      int     _kind;      // the width of the value in bytes or 0 for an Entry
+   };
+   struct Level {
+      std::size_t _rtop;  // top of the record array
+      std::size_t _bcur;  // current entry chunk
+      std::size_t _btop;  // top of the current entry chunk
+      long        _node;
+   };
+   struct Chunk {
+      char*       _base;
+      std::size_t _sz;
+   };
+   const std::size_t  _isz;
+   Record*            _rec;
+   std::size_t        _rsz;
+   std::size_t        _rtop;
+   std::vector<Level> _tops;
+   std::vector<Chunk> _chunks;
+   std::size_t        _bcur;
+   std::size_t        _btop;
    mutable int             _magic;
    long  _lastNode;
-   char* _block;
-   std::size_t  _bsz;
-   std::size_t  _btop;
    bool      _enabled;
+   std::vector<std::pair<void*,std::size_t>> _tracked;
+   std::size_t _nbTracked;
+   std::size_t _maxRecords;  // high-water marks (updated on pop, when the trail is at a local maximum)
+   std::size_t _maxChunks;
+   int         _maxDepth;
+   void growRecords();
+   void nextChunk(std::size_t sz);
+   Record* newRecord() {
+      if (_rtop == _rsz)
+         growRecords();
+      return _rec + _rtop++;
+   }
+   void* allocate(std::size_t sz);
+   template <class T> class ValueEntry : public Entry {
+      T* _at;
+      T  _old;
+   public:
+      ValueEntry(T* at) : _at(at),_old(*at) {}
+      void restore() noexcept override { *_at = _old;}
+      bool regions(const std::function<void(void*,std::size_t)>& f) const override {
+         if (!std::is_trivially_copyable<T>::value)
+            return false;
+         f(_at,sizeof(T));
+         return true;
+      }
+   };
+   class BlockEntry : public Entry {  // the old bytes immediately follow the entry
+      char*       _at;
+      std::size_t _len;
+   public:
+      BlockEntry(void* at,std::size_t len) : _at((char*)at),_len(len) { std::memcpy(old(),_at,_len);}
+      char* old() noexcept { return reinterpret_cast<char*>(this + 1);}
+      void restore() noexcept override { std::memcpy(_at,old(),_len);}
+      bool regions(const std::function<void(void*,std::size_t)>& f) const override {
+         f(_at,_len);
+         return true;
+      }
+   };
+   friend class Snapshot;
+   template <class T> struct Plain : std::is_trivially_copyable<T> {};
+   template <class T> struct Plain<handle_ptr<T>> : std::true_type {}; // a handle is a bare pointer
+   template <class T> static constexpr bool isPlain() {
+      return Plain<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+   }
 public:
-   Trailer();
+   /**
+    * @brief Usage statistics of a trailer.
+    */
+   struct Stats {
+      std::size_t records;     //!< records on the trail now
+      std::size_t maxRecords;  //!< largest number of records ever held
+      std::size_t capacity;    //!< records the array can hold without growing
+      std::size_t chunks;      //!< entry chunks allocated
+      std::size_t maxChunks;   //!< largest number of entry chunks ever in use
+      std::size_t bytes;       //!< total memory held by the records and the chunks
+      int         maxDepth;    //!< deepest level ever reached
+      friend std::ostream& operator<<(std::ostream& os,const Stats& s) {
+         return os
+            << "Trail Records = " << s.records << " (peak " << s.maxRecords << ", capacity " << s.capacity << ")" << std::endl
+            << "Trail Chunks = " << s.chunks << " (peak in use " << s.maxChunks << ")" << std::endl
+            << "Trail Bytes = " << s.bytes << std::endl
+            << "Trail Depth = " << s.maxDepth << std::endl;
+      }
+   };
+   /**
+    * @param initSize the initial size (in bytes) of the record array and of the first entry chunk.
+    * Nothing is allocated for entries until the first one is trailed.
+    */
+   Trailer(std::size_t initSize = TRAILSIZE);
    ~Trailer();
    void enable()  override { _enabled = true;}
-   void trail(Entry* e) { if (e) _trail.push(e);}
+   void trail(Entry* e) {
+      if (e) {
+         Record* r = newRecord();
+         r->_entry = e;
+         r->_kind  = 0;
+      }
+   }
+   /**
+    * Records the current value held at `at` so that it is restored on backtrack.
+    * Nothing is recorded until the trailer is enabled (the root state is never restored).
+    * @param at the address of the value about to be modified
+    */
+   template <class T> void save(T* at) {
+      if constexpr (isPlain<T>()) {
+         if (_enabled) {
+            Record* r = newRecord();
+            r->_at   = at;
+            r->_u64  = 0;
+            std::memcpy(&r->_u64,at,sizeof(T));
+            r->_kind = sizeof(T);
+            return;
+         }
+      }
+      void* buf = _enabled ? allocate(sizeof(ValueEntry<T>)) : nullptr;
+      if (buf) trail(new (buf) ValueEntry<T>(at));
+   }
+   /**
+    * Declares memory that is part of the state although its updates are not trailed, e.g., the
+    * order of the elements of a sparse set whose size is trailed. Backtracking does not need it,
+    * but a Snapshot copies it entirely. The declaration itself is undone on backtrack.
+    * @param at the address of the memory
+    * @param len its length in bytes
+    */
+   void track(void* at,std::size_t len);
+   /**
+    * Trails the `len` bytes at `at` (as a value record when possible) before overwriting them.
+    * @param at the address of the memory to overwrite
+    * @param src the new content
+    * @param len the number of bytes to copy
+    */
+   void write(void* at,const void* src,std::size_t len);
    typedef handle_ptr<Trailer> Ptr;
-   void resize();
    int magic() const { return _magic;}
    void incMagic() { _magic++;}
    long push();
@@ -51,7 +207,12 @@ public:
    void pop();
    void popToNode(long node);
    void clear();
-   int depth() const noexcept { return _tops.size();}
+   int depth() const noexcept { return (int)_tops.size();}
+   /**
+    * The number of records currently on the trail.
+    */
+   std::size_t size() const noexcept { return _rtop;}
+   Stats stats() const noexcept;
    void saveState() override;
    void restoreState() override;
    void withNewState(const std::function<void(void)>& body) override;
@@ -67,17 +228,17 @@ inline void* operator new[](std::size_t sz,Trailer::Ptr& e) noexcept
 
 inline void* operator new(std::size_t sz,Trailer::Ptr& e) noexcept
 {
-   if (e->_enabled) {
-      char* ptr = e->_block + e->_btop;
-      e->_btop += sz;
-      if (e->_btop >= e->_bsz) {
-         e->_btop -= sz;
-         e->resize();
-         ptr = e->_block + e->_btop;
-         e->_btop += sz;
-      }
-      return ptr;
-   } else return nullptr;
+   return e->_enabled ? e->allocate(sz) : nullptr;
+}
+
+inline void* Trailer::allocate(std::size_t sz)
+{
+   sz = (sz + 7) & ~std::size_t(7);
+   if (_bcur == _chunks.size() || _btop + sz > _chunks[_bcur]._sz)
+      nextChunk(sz);
+   char* ptr = _chunks[_bcur]._base + _btop;
+   _btop += sz;
+   return ptr;
 }
 //
 //class CommandList;
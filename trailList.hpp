@@ -65,6 +65,16 @@ public:
         // Allocate list node on the stack allocator
         return _head = new (_store) revNode(this,_sm,nullptr,_head,std::move(v));
     }
+    bool empty() const { return _head == nullptr;}
+    /**
+     * Applies `f` to every element and (reversibly) detaches the nodes of the elements it rejects.
+     * @param f returns false to drop an element
+     */
+    template <class F> void filter(F f) {
+        for(revNode* cur = _head;cur;cur = cur->_next)
+            if (!f(cur->_value))
+                cur->detach();
+    }
     iterator begin()  { return iterator(_head);}
     iterator end()    { return iterator(nullptr);}
     friend std::ostream& operator<<(std::ostream& os,const trailList<T>& rl) {
@@ -79,4 +89,15 @@ public:
 
 typedef trailList<Constraint::Ptr>::revNode TLCNode;
 
+/**
+ * @brief A constraint advised of the changes of a variable (see Constraint::advise).
+ * The constraint sees the variable through the view \f$a * x + b\f$.
+ */
+struct IntAdvisor {
+    Constraint::Ptr _c;
+    int             _idx;
+    int             _a,_b;
+};
+typedef trailList<IntAdvisor>::revNode TLANode;
+
 #endif
@@ -35,25 +35,18 @@ public:
    public:
       TVecSetter(Trailer::Ptr t,T* at) : _t(t),_at(at) {}
       TVecSetter& operator=(T&& v) {
-         _t->trail(new (_t) TrailEntry<T>(_at));
+         _t->save(_at);
          *_at = std::move(v);
          return *this;
       }
       template <class U> TVecSetter& operator=(const U& nv) {
-         _t->trail(new (_t) TrailEntry<T>(_at));
+         _t->save(_at);
          *_at  = nv;
          return *this;
       }
       operator T() const noexcept   { return *_at;}
       T operator->() const noexcept { return *_at;}
    };
-   template <class U> class TrailEntry : public Entry {
-      U* _at;
-      U  _old;
-   public:
-      TrailEntry(U* ptr) : _at(ptr),_old(*ptr) {}
-      void restore() noexcept { *_at = _old;}
-   };
    TVec() : _t(nullptr),_sz(0),_msz(0),_data(nullptr),_magic(0) {}
    TVec(Trailer::Ptr t,Storage::Ptr mem,SZT s)
       : _t(t),_sz(0),_msz(s),_magic(t->magic()) {
@@ -74,7 +67,7 @@ public:
    }
    Trailer::Ptr getTrail() { return _t;}
    void clear() {
-      _t->trail(new (_t) TrailEntry<SZT>(&_sz));
+      _t->save(&_sz);
       _sz = 0;
       _magic = _t->magic();
    }
@@ -85,20 +78,20 @@ public:
          T* nd = new (mem) T[newSize];
          for(SZT i=0;i< _msz;i++)
             nd[i] = _data[i];
-         _t->trail(new (_t) TrailEntry<T*>(&_data));
-         _t->trail(new (_t) TrailEntry<SZT>(&_msz));
+         _t->save(&_data);
+         _t->save(&_msz);
          _data = nd;
          _msz = newSize;
       }
       at(_sz,p);
-      _t->trail(new (_t) TrailEntry<SZT>(&_sz));
+      _t->save(&_sz);
       _sz += 1;
       _magic = _t->magic();
       assert(_sz > 0);
    }
    T pop_back() {
       T rv = _data[_sz - 1];
-      _t->trail(new (_t) TrailEntry<SZT>(&_sz));
+      _t->save(&_sz);
       _sz -= 1;
       _magic = _t->magic();
       return rv;
@@ -108,7 +101,7 @@ public:
       assert(i >= 0 && i < _sz);
       if (i < _sz - 1)
          at(i,_data[_sz - 1]);
-      _t->trail(new (_t) TrailEntry<SZT>(&_sz));
+      _t->save(&_sz);
       _sz -= 1;
       _magic = _t->magic();
       return _sz;
@@ -117,7 +110,7 @@ public:
    const T operator[](SZT i) const noexcept    { return _data[i];}
    TVecSetter operator[](SZT i) noexcept { return TVecSetter(_t,_data+i);}
    void at(SZT i,const T& nv) {
-      _t->trail(new (_t) TrailEntry<T>(_data+i));
+      _t->save(_data+i);
       _data[i] = nv;
    }
    bool changed() const noexcept { return _magic == _t->magic();}
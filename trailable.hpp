@@ -32,8 +32,7 @@ template<class T> class trail {
    T                _value;
    void save(int nm) {
       _magic = nm;
-      Entry* entry = new (_ctx) TrailEntry(&_value);
-      _ctx->trail(entry);
+      _ctx->save(&_value);
    }
 public:
    /**
@@ -100,18 +99,6 @@ public:
     * @return the value prior to the increment.
     */   
    T operator--(int); // post-decrement
-   /**
-    * @brief Nested class to record the old value when a write occurs.
-    * An instance of this class is to be written on the trail each time
-    * the object modifies the value it represents.
-    */   
-   class TrailEntry: public Entry {
-      T*  _at;
-      T  _old;
-   public:
-      TrailEntry(T* at) : _at(at),_old(*at) {}
-      void restore() noexcept { *_at = _old;}
-   };
 };
 
 template<class T>
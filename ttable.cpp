@@ -29,29 +29,34 @@ Profile *CumulativeTT::buildProfile() {
 
 void CumulativeTT::propagate()
 {
-   std::unique_ptr<Profile> profile(buildProfile());
-   for (int i = 0u; i < profile->size(); i++)
-      if (profile->get(i).getHeight() > _capa) {
-         profile = nullptr;
-         failNow();
-      }
-   for (auto i = 0u; i < _start.size(); i++) {
-      if (!_start[i]->isBound()) {
-         int j = profile->rectangleIndex(_start[i]->min());
-         int t = _start[i]->min();
-         while (j < profile->size() &&
-                profile->get(j).getStart() < std::min(t + _duration[i], _start[i]->max())) {
-            if (_capa - _demand[i] < profile->get(j).getHeight())
-               t = std::min(profile->get(j).getEnd(), _start[i]->max());
-            j++;
-         }
-         TRYFAIL
-            _start[i]->removeBelow(t);
-         ONFAIL {
-            profile = nullptr; // deallocate and fail again
+   bool moved;
+   do {
+      moved = false;
+      std::unique_ptr<Profile> profile(buildProfile());
+      for (int i = 0u; i < profile->size(); i++)
+         if (profile->get(i).getHeight() > _capa) {
+            profile = nullptr;
             failNow();
-         } ENDFAIL;
+         }
+      for (auto i = 0u; i < _start.size(); i++) {
+         if (!_start[i]->isBound()) {
+            int j = profile->rectangleIndex(_start[i]->min());
+            int t = _start[i]->min();
+            while (j < profile->size() &&
+                   profile->get(j).getStart() < std::min(t + _duration[i], _start[i]->max())) {
+               if (_capa - _demand[i] < profile->get(j).getHeight())
+                  t = std::min(profile->get(j).getEnd(), _start[i]->max());
+               j++;
+            }
+            moved |= t > _start[i]->min();
+            TRYFAIL
+               _start[i]->removeBelow(t);
+            ONFAIL {
+               profile = nullptr; // deallocate and fail again
+               failNow();
+            } ENDFAIL;
+         }
       }
-   }
+   } while (moved);   // a start that moved may have grown a mandatory part
 }   
 
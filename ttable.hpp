@@ -39,6 +39,8 @@ public:
         _start(start.size(), Factory::alloci(start[0]->getStore())),
         _end(_start.size(), Factory::alloci(start[0]->getStore()))
    {
+      setPriority(QUADRATIC);
+      setIdempotent(true);   // propagate() loops until its own pruning no longer changes the profile
       using namespace Factory;
       int i  = 0;
       for(auto& xi : start) {
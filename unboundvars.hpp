@@ -0,0 +1,84 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __UNBOUNDVARS_H
+#define __UNBOUNDVARS_H
+
+#include <vector>
+#include "trailable.hpp"
+
+/**
+ * @brief Reversible set of the unbound variables of a container, for the branchings to iterate
+ * instead of the container itself.
+ *
+ * Like a SparseSet, it permutes the positions of the variables so that the first `size` ones are
+ * in the set. Iterating drops the bound variables it meets by swapping them past the end of the set:
+ * backtracking brings them back for free. The permutation is trailed along with the size, so that
+ * the set also survives the restoration of a checkpoint taken on another branch (see BFSearch).
+ * It must be created at the root, before the search starts.
+ */
+template <class Var> class UnboundVars {
+   std::vector<Var>        _x;      // the variables, in the order of the container
+   std::vector<trail<int>> _at;     // a permutation of the positions. The first _size ones may be unbound.
+   trail<int>              _size;
+public:
+   template <class Container> UnboundVars(Trailer::Ptr sm,const Container& c)
+      : _x(c.begin(),c.end()),_size(sm,(int)_x.size()) {
+      _at.reserve(_x.size());
+      for(auto i = 0u;i < _x.size();i++)
+         _at.emplace_back(sm,(int)i);
+   }
+   /**
+    * Calls `f(x,i)` on every unbound variable `x` (`i` is its position in the container), in no
+    * particular order, and drops the bound variables from the set.
+    */
+   template <class F> void forEach(F f) {
+      int n = _size;
+      for(int k = 0;k < n;) {
+         const int i = _at[k];
+         if (_x[i]->isBound()) {
+            --n;
+            _at[k] = (int)_at[n];
+            _at[n] = i;
+         } else {
+            f(_x[i],i);
+            k++;
+         }
+      }
+      if (n != _size)
+         _size = n;
+   }
+   /**
+    * @return the unbound variable with the smallest `f(x)` (ties go to the first one in the
+    * container, like with selectMin) or a null pointer once they are all bound
+    */
+   template <class Fun> Var selectMin(Fun f) {
+      Var best = Var();
+      int bi = -1;
+      decltype(f(_x[0])) bv {};
+      forEach([&](const Var& x,int i) {
+                 auto v = f(x);
+                 if (bi < 0 || v < bv || (!(bv < v) && i < bi)) {
+                    best = x;
+                    bi = i;
+                    bv = v;
+                 }
+              });
+      return best;
+   }
+   int size() const { return _size;}
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#include "varheap.hpp"
+
+void VarHeap::up(int p)
+{
+   const int i = _heap[p];
+   while (p > 0) {
+      const int q = (p - 1) / 2;
+      const int j = _heap[q];
+      if (!before(i,j))
+         break;
+      place(p,j);
+      p = q;
+   }
+   place(p,i);
+}
+
+void VarHeap::down(int p)
+{
+   const int i = _heap[p];
+   const int n = _n;
+   while (true) {
+      int c = 2 * p + 1;
+      if (c >= n)
+         break;
+      if (c + 1 < n && before(_heap[c + 1],_heap[c]))
+         c++;
+      const int j = _heap[c];
+      if (!before(j,i))
+         break;
+      place(p,j);
+      p = c;
+   }
+   place(p,i);
+}
+
+void VarHeap::post()
+{
+   int n = 0;
+   for(auto i = 0u;i < _x.size();i++)
+      if (!_x[i]->isBound())
+         place(n++,i);
+   _n = n;
+   for(int p = n / 2 - 1;p >= 0;p--)
+      down(p);
+   for(auto i = 0u;i < _x.size();i++)
+      if (!_x[i]->isBound())
+         _x[i]->adviseOnDomainChange(this,i);
+}
+
+// Domains only shrink: the variable moves up, or leaves once bound.
+bool VarHeap::advise(int idx,const IntDelta& d)
+{
+   const int p = _pos[idx];
+   if (p < 0)
+      return false;
+   if (d.isBound()) {
+      const int n = _n - 1;
+      _n = n;
+      _pos[idx] = -1;
+      if (p < n) {   // the last variable fills the hole
+         const int last = _heap[n];
+         place(p,last);
+         up(p);
+         down(_pos[last]);
+      }
+   } else
+      up(p);
+   return false;
+}
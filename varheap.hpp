@@ -0,0 +1,66 @@
+/*
+ * mini-cp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License  v3
+ * as published by the Free Software Foundation.
+ *
+ * mini-cp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY.
+ * See the GNU Lesser General Public License  for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with mini-cp. If not, see http://www.gnu.org/licenses/lgpl-3.0.en.html
+ *
+ * Copyright (c)  2018. by Laurent Michel, Pierre Schaus, Pascal Van Hentenryck
+ */
+
+#ifndef __VARHEAP_H
+#define __VARHEAP_H
+
+#include <vector>
+#include "acstr.hpp"
+#include "intvar.hpp"
+
+/**
+ * @brief Reversible binary heap of the unbound variables of a branching, smallest domain first
+ * (ties go to the variable that comes first, like with selectMin).
+ *
+ * The variables advise the heap of the changes of their domains (see Constraint::advise): a variable
+ * whose domain shrinks moves up and a bound variable leaves. Every write is trailed, so backtracking
+ * restores the heap with the domains. Selecting the variable costs O(1) and each update O(log n),
+ * instead of a scan of all the variables at every node.
+ * The heap must be posted at the root, before the search starts.
+ */
+class VarHeap : public Constraint {
+   std::vector<var<int>::Ptr> _x;
+   trail<int>*                _heap;   // the indices of the variables in heap order
+   trail<int>*                _pos;    // the position of every variable in _heap (-1 once bound)
+   trail<int>                 _n;
+   bool before(int i,int j) const {
+      const int si = _x[i]->size(),sj = _x[j]->size();
+      return si < sj || (si == sj && i < j);
+   }
+   void place(int p,int i) { _heap[p] = i;_pos[i] = p;}
+   void up(int p);
+   void down(int p);
+public:
+   typedef handle_ptr<VarHeap> Ptr;
+   template <class Vec> VarHeap(CPSolver::Ptr cp,const Vec& x)
+      : Constraint(cp),_x(x.begin(),x.end()),_n(cp->getStateManager(),0) {
+      setPriority(UNARY);
+      _heap = new (cp) trail<int>[_x.size()];
+      _pos  = new (cp) trail<int>[_x.size()];
+      for(auto i = 0u;i < _x.size();i++) {
+         new (_heap+i) trail<int>(cp->getStateManager(),-1);
+         new (_pos+i) trail<int>(cp->getStateManager(),-1);
+      }
+   }
+   void post() override;
+   bool advise(int idx,const IntDelta& d) override;
+   /**
+    * @return the unbound variable with the smallest domain (`nullptr` once they are all bound)
+    */
+   var<int>::Ptr top() const { return _n > 0 ? _x[_heap[0]] : var<int>::Ptr();}
+   int size() const { return _n;}
+};
+
+#endif
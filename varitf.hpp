@@ -42,6 +42,11 @@ protected:
     */ 
    void setId(int id) override { _id = id;}
 public:
+   /**
+    * Variables get their identifier when registered with their solver. Views are never
+    * registered and keep the identifier -1.
+    */
+   var() : _id(-1) {}
    /**
     * Looks up the  variable idendifier (signed 32 bit value, non-negative)
     * @return the variable identifier.
@@ -104,6 +109,19 @@ n    * variables must be solver allocated via the Factory.)
     * @see size()
     */
    virtual bool changed() const noexcept = 0;
+   /**
+    * Expresses \f$this \; rel \; v\f$ as a literal on the variable underneath (views are never
+    * registered and have no identifier). It is used to explain propagations while learning.
+    * @return the literal. A literal with no variable (-1) stands for a literal that always holds.
+    * @see Constraint::explain
+    */
+   virtual Literal literal(Literal::Rel rel,int v) const = 0;
+   /**
+    * The weighted degree of the variable, used by the dom/wdeg heuristic. It is maintained as the constraints
+    * fail and are entailed, so reading it takes constant time.
+    * @return the sum of the weights (see Constraint::weight) of the active constraints posted on the variable
+    */
+   virtual unsigned long weightedDegree() const = 0;
    /**
     * Binds the variable to the given value. Namely, the domain
     * changes to contain only the specified value. All others are
@@ -145,6 +163,50 @@ n    * variables must be solver allocated via the Factory.)
     * @param newMax is the new maximum
     */
    virtual void updateBounds(int newMin,int newMax) = 0;
+   /**
+    * Removes a set of values from the domain at once. Variables with a domain of their own
+    * update it word by word and notify the change once, rather than once per value.
+    * The values not in the domain are ignored. Note that this operation can raise a
+    * failure in case the domain becomes empty.
+    * @param vals the values to remove (in any order)
+    */
+   virtual void removeSet(const std::vector<int>& vals) {
+      for(int v : vals)
+         remove(v);
+   }
+   /**
+    * Keeps only the values of the domain that appear in a list (see `removeSet`).
+    * @param vals the values to keep, sorted in increasing order
+    */
+   virtual void restrictTo(const std::vector<int>& vals) {
+      if (vals.empty()) {
+         removeBelow(max() + 1);
+         return;
+      }
+      updateBounds(vals.front(),vals.back());
+      auto k = vals.begin();
+      const int ub = max();
+      for(int v = min();v <= ub;v++) {
+         while (*k < v) ++k;
+         if (*k != v)
+            remove(v);
+      }
+   }
+   /**
+    * Keeps only the values of the domain that appear in a bitmask (see `removeSet`).
+    * @param from the value of the first bit of the mask
+    * @param mask the 64-bit words of the mask (lowest bit first). Value `v` is kept if and only if bit
+    * `(v - from) % 64` of word `(v - from) / 64` is set.
+    */
+   virtual void intersectWith(int from,const std::vector<unsigned long long>& mask) {
+      updateBounds(from,from + 64 * (int)mask.size() - 1);
+      const int ub = max();
+      for(int v = min();v <= ub;v++) {
+         const int b = v - from;
+         if (((mask[b >> 6] >> (b & 0x3f)) & 0x1) == 0)
+            remove(v);
+      }
+   }
 
    /**
     * Observer. This method registers a new observer with the variable
@@ -229,6 +291,29 @@ n    * variables must be solver allocated via the Factory.)
     * @see Constraint
     */ 
    virtual TLCNode* propagateOnDomainChange(Constraint::Ptr c ) = 0;
+   /**
+    * Advisor. This method registers the specified constraint to be advised, with the delta, of
+    * every update of the bounds of the variable (see Constraint::advise). The constraint is
+    * scheduled when its `advise` method asks for it.
+    * @param c the constraint to advise
+    * @param idx the index handed back to `c` with every delta (e.g., the position of the variable in its scope)
+    * @return a pointer to the advisor that can be used to `detach` it.
+    */
+   TLANode* adviseOnBoundChange(Constraint::Ptr c,int idx)  { return addAdvisor(IntAdvisor { c,idx,1,0 },false);}
+   /**
+    * Advisor. This method registers the specified constraint to be advised, with the delta, of
+    * every update of the domain of the variable (see Constraint::advise).
+    * @param c the constraint to advise
+    * @param idx the index handed back to `c` with every delta
+    * @return a pointer to the advisor that can be used to `detach` it.
+    */
+   TLANode* adviseOnDomainChange(Constraint::Ptr c,int idx) { return addAdvisor(IntAdvisor { c,idx,1,0 },true);}
+   /**
+    * Registers an advisor. Views compose their own transformation with the one of the advisor.
+    * @param a the advisor
+    * @param domain true to advise on every update of the domain, false for bounds updates only.
+    */
+   virtual TLANode* addAdvisor(IntAdvisor a,bool domain) = 0;
    /** 
     * Polymorphic variable printing.
     * This method gets used by the output operator on `const var<int>&`